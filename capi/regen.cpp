@@ -0,0 +1,231 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+// exports the functions (@see REGEN_API)
+#define REGEN_BUILDING
+#include "regen.h"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#include "../regen/regen.hpp"
+
+struct regen_pattern
+{
+    regen::Pattern pattern;
+};
+
+namespace
+{
+    /** strings generated from the same seed, the strings of a batch are split in blocks */
+    const std::size_t s_blockSize = 1024;
+
+    /** number of blocks generated in parallel per thread before they are copied to the buffer */
+    const std::size_t s_blocksPerThread = 4;
+
+    thread_local std::string t_lastError;
+
+    struct Block
+    {
+        std::string data;
+
+        /** end of each string in data */
+        std::vector<std::size_t> ends;
+    };
+
+    regen_status fail( regen_status status, const char* message )
+    {
+        t_lastError = message;
+        return status;
+    }
+
+    /**
+     * runs f, turning its exceptions into statuses
+     * 
+     * @param runtimeStatus status of std::runtime_error, i.e. invalid regex or failed generation
+     */
+    template<class F>
+    regen_status guard( regen_status runtimeStatus, F f )
+    {
+        try
+        {
+            return f();
+        }
+        catch( std::bad_alloc& )
+        {
+            return fail( REGEN_OUT_OF_MEMORY, "out of memory" );
+        }
+        catch( std::runtime_error& ex )
+        {
+            return fail( runtimeStatus, ex.what() );
+        }
+        catch( std::logic_error& ex )
+        {
+            return fail( REGEN_INVALID_ARGUMENT, ex.what() );
+        }
+        catch( std::exception& ex )
+        {
+            return fail( REGEN_ERROR, ex.what() );
+        }
+        catch( ... )
+        {
+            return fail( REGEN_ERROR, "unknown error" );
+        }
+    }
+
+    /**
+     * @return the pool of the parallel batches, created on first use
+     * 
+     * it is never destroyed, so that no thread is joined while the library is unloaded
+     */
+    regen::ThreadPool& pool()
+    {
+        static regen::ThreadPool* const res = new regen::ThreadPool( std::max( 1u, std::thread::hardware_concurrency() ) );
+        return *res;
+    }
+
+    void generateBlock( const regen::Pattern& pattern, std::uint64_t seed, std::size_t block, std::size_t count, Block& res )
+    {
+        regen::Pattern copy( pattern );
+        copy.seed( regen::substreamSeed( seed, block ) );
+
+        res.data.clear();
+        res.ends.clear();
+        for( std::size_t i = 0; i < count; ++i )
+        {
+            copy.generate( res.data );
+            res.ends.push_back( res.data.size() );
+        }
+    }
+}
+
+extern "C"
+{
+    regen_status regen_compile( const char* regex,
+                                size_t repetition_max,
+                                size_t repetition_min,
+                                const char* restricted_range,
+                                regen_pattern** pattern )
+    {
+        if( !regex || !pattern )
+            return fail( REGEN_INVALID_ARGUMENT, "regex and pattern cannot be NULL" );
+
+        return guard( REGEN_INVALID_REGEX, [&]
+        {
+            const regen::Generator generator( repetition_max, repetition_min, restricted_range ? restricted_range : "" );
+            *pattern = new regen_pattern{ regen::Pattern( regex, generator ) };
+            return REGEN_OK;
+        } );
+    }
+
+    void regen_free( regen_pattern* pattern )
+    {
+        delete pattern;
+    }
+
+    size_t regen_max_length( const regen_pattern* pattern )
+    {
+        return pattern ? pattern->pattern.analysis().stats().maxLength : 0;
+    }
+
+    regen_status regen_generate_batch( const regen_pattern* pattern,
+                                       uint64_t seed,
+                                       size_t count,
+                                       size_t threads,
+                                       char* buffer,
+                                       size_t capacity,
+                                       size_t* offsets,
+                                       size_t* generated )
+    {
+        if( !pattern || !offsets || !generated || ( !buffer && capacity > 0 ) )
+            return fail( REGEN_INVALID_ARGUMENT, "pattern, buffer, offsets and generated cannot be NULL" );
+
+        *generated = 0;
+        offsets[0] = 0;
+
+        return guard( REGEN_ERROR, [&]
+        {
+            const std::size_t cores = std::max( 1u, std::thread::hardware_concurrency() );
+            const std::size_t blocks = ( count + s_blockSize - 1 ) / s_blockSize;
+            threads = std::min( { threads == 0 ? cores : threads, cores, std::max<std::size_t>( blocks, 1 ) } );
+
+            std::vector<Block> window( threads * s_blocksPerThread );
+            std::size_t size = 0;
+
+            for( std::size_t first = 0; first < blocks; first += window.size() )
+            {
+                const std::size_t last = std::min( blocks, first + window.size() );
+
+                // generate a window of blocks, each thread taking the next block left, then copy them in order
+                std::atomic<std::size_t> next( first );
+                auto work = [&]
+                {
+                    for( std::size_t b = next++; b < last; b = next++ )
+                        generateBlock( pattern->pattern, seed, b, std::min( s_blockSize, count - b * s_blockSize ), window[b - first] );
+                };
+                if( threads == 1 )
+                {
+                    work();
+                }
+                else
+                {
+                    std::vector<std::future<void>> futures;
+                    for( std::size_t t = 0; t < threads; ++t )
+                        futures.push_back( pool().submit( work ) );
+                    for( std::future<void>& future : futures )
+                        future.wait();
+                    for( std::future<void>& future : futures )
+                        future.get();
+                }
+
+                for( std::size_t b = first; b < last; ++b )
+                {
+                    const Block& block = window[b - first];
+                    std::size_t fit = block.ends.size();
+                    if( size + block.data.size() > capacity )
+                        fit = std::upper_bound( block.ends.begin(), block.ends.end(), capacity - size ) - block.ends.begin();
+
+                    const std::size_t bytes = fit > 0 ? block.ends[fit - 1] : 0;
+                    if( bytes > 0 )
+                        std::memcpy( buffer + size, block.data.data(), bytes );
+                    for( std::size_t i = 0; i < fit; ++i )
+                        offsets[*generated + i + 1] = size + block.ends[i];
+                    size += bytes;
+                    *generated += fit;
+
+                    if( fit < block.ends.size() )
+                        return fail( REGEN_BUFFER_TOO_SMALL, "the buffer is too small for all the strings" );
+                }
+            }
+
+            return REGEN_OK;
+        } );
+    }
+
+    const char* regen_last_error( void )
+    {
+        return t_lastError.c_str();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#ifndef REGEN_C_API_H
+#define REGEN_C_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the library defines REGEN_BUILDING to export the functions, its clients import them */
+#if defined( _WIN32 ) && defined( REGEN_BUILDING )
+#define REGEN_API __declspec( dllexport )
+#elif defined( _WIN32 )
+#define REGEN_API __declspec( dllimport )
+#else
+#define REGEN_API __attribute__( ( visibility( "default" ) ) )
+#endif
+
+/**
+ * C interface of libRegen, built as a shared library
+ * 
+ * Strings are generated in batches into buffers owned by the caller, so that
+ * bindings (Python, Go...) cross the interface once per batch instead of once per string.
+ * No function throws, they return a status and regen_last_error() describes the last failure.
+ */
+
+typedef enum regen_status
+{
+    REGEN_OK = 0,
+    REGEN_INVALID_ARGUMENT = 1,
+    REGEN_INVALID_REGEX = 2,
+    /** the buffer is full, the strings which fit were generated */
+    REGEN_BUFFER_TOO_SMALL = 3,
+    REGEN_OUT_OF_MEMORY = 4,
+    REGEN_ERROR = 5
+} regen_status;
+
+/** compiled regex, safe to use from several threads at once */
+typedef struct regen_pattern regen_pattern;
+
+/**
+ * compiles a regex
+ * 
+ * @param regex regular expression (UTF-8 encoded, nul terminated)
+ * @param repetition_max max number of repetitions for + and * (5 in the C++ interface)
+ * @param repetition_min min number of repetitions for + and * (0 in the C++ interface)
+ * @param restricted_range range of characters that can be generated e.g. "[a-zA-Z]", NULL or "" for none
+ * @param pattern receives the compiled regex, to release with regen_free
+ */
+REGEN_API regen_status regen_compile( const char* regex,
+                                      size_t repetition_max,
+                                      size_t repetition_min,
+                                      const char* restricted_range,
+                                      regen_pattern** pattern );
+
+/** releases a compiled regex, NULL is ignored */
+REGEN_API void regen_free( regen_pattern* pattern );
+
+/**
+ * @return the maximum length in bytes of a generated string, to size the buffers
+ *         (SIZE_MAX if it does not fit in a size_t)
+ */
+REGEN_API size_t regen_max_length( const regen_pattern* pattern );
+
+/**
+ * generates a batch of strings, packed one after the other in a buffer
+ * 
+ * The strings depend on the seed only, not on the number of threads.
+ * String i is buffer[offsets[i], offsets[i + 1]), it is not nul terminated.
+ * The threads are those of a pool shared by all the batches of the process, created by the first parallel batch.
+ * 
+ * @param pattern compiled regex
+ * @param seed seed of the batch
+ * @param count number of strings to generate
+ * @param threads number of threads generating the strings, 0 for the number of cores (which is also the maximum)
+ * @param buffer receives the strings
+ * @param capacity size of buffer in bytes
+ * @param offsets receives count + 1 offsets, offsets[0] = 0
+ * @param generated receives the number of strings generated, count unless the buffer is too small
+ * 
+ * @return REGEN_BUFFER_TOO_SMALL if only the first *generated strings fit in the buffer
+ */
+REGEN_API regen_status regen_generate_batch( const regen_pattern* pattern,
+                                             uint64_t seed,
+                                             size_t count,
+                                             size_t threads,
+                                             char* buffer,
+                                             size_t capacity,
+                                             size_t* offsets,
+                                             size_t* generated );
+
+/**
+ * @return description of the last failure of a call made by this thread
+ */
+REGEN_API const char* regen_last_error( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
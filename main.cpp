@@ -27,6 +27,9 @@
 static const std::size_t s_default_rep_max = 5;
 static const std::size_t s_default_rep_min = 0;
 
+/** errors reported, test_regen fails when there is any */
+static std::size_t s_errors = 0;
+
 void test( const std::string& regex,
             std::size_t repetition_max = s_default_rep_max,
             std::size_t repetition_min = s_default_rep_min,
@@ -43,15 +46,257 @@ void test( const std::string& regex,
 
     try
     {
-        std::cout << regen::generate( regex, regen::Generator( repetition_max, repetition_min, restricted_range ) ) << "\n";
+        auto sample = regen::generate( regex, regen::Generator( repetition_max, repetition_min, restricted_range ) );
+        std::cout << sample << "\n";
+
+        if( !regen::matches( regex, sample ) )
+        {
+            std::cerr << "Error: the generated string does not match the regex\n";
+            ++s_errors;
+        }
     }
     catch( std::runtime_error& ex )
     {
         std::cerr << "Error: " << ex.what() << "\n";
+        ++s_errors;
     }
     catch( std::logic_error& ex )
     {
         std::cerr << "Logic error: " << ex.what() << "\n";
+        ++s_errors;
+    }
+
+    std::cout << std::endl;
+}
+
+/**
+ * @return an error if a node of the derivation does not cover exactly its children,
+ * or if the part of a UNION node does not match its regex
+ */
+std::string checkDerivation( const regen::Derivation& derivation )
+{
+    const std::string& str = derivation.str();
+    for( std::size_t i = 0; i < derivation.size(); ++i )
+    {
+        const regen::Derivation::Node& node = derivation[i];
+        const std::size_t begin = derivation.begin( i );
+        if( begin + node.length > str.size() || derivation.end( i ) > derivation.size() )
+            return "node " + std::to_string( i ) + " is out of bounds";
+
+        // the children follow each other from the begin to the end of their parent
+        std::size_t position = begin;
+        for( std::size_t child = i + 1; child < derivation.end( i ); child = derivation.end( child ) )
+        {
+            if( derivation.parent( child ) != i || derivation.begin( child ) != position )
+                return "child " + std::to_string( child ) + " of node " + std::to_string( i ) + " is misplaced";
+            position += derivation[child].length;
+        }
+        if( derivation.end( i ) > i + 1 && position != begin + node.length )
+            return "the children of node " + std::to_string( i ) + " do not cover it";
+
+        if( node.type == regen::Derivation::Node::UNION
+            && !regen::Matcher( *static_cast<const regen::Re*>( node.ast ) ).matches( boost::string_view( str ).substr( begin, node.length ) ) )
+            return "the part of node " + std::to_string( i ) + " does not match its regex";
+    }
+    return std::string();
+}
+
+/**
+ * regenerates random nodes of a derivation and checks the derivation after each mutation
+ */
+void testMutations( const std::string& regex, std::size_t mutations )
+{
+    std::cout << regex << " {" << mutations << " mutations}\n";
+
+    try
+    {
+        auto tokens = regen::lexer( regex );
+        const regen::Re re = regen::Parser().parse( tokens );
+        regen::Generator generator;
+        generator.seed( 42 );
+
+        regen::Derivation derivation;
+        generator.generate( re, derivation );
+        boost::random::mt19937 rng( 42 );
+        for( std::size_t i = 0; i < mutations; ++i )
+        {
+            const std::size_t node = boost::random::uniform_int_distribution<std::size_t>( 0, derivation.size() - 1 )( rng );
+            generator.mutate( derivation, node );
+
+            std::string error = checkDerivation( derivation );
+            if( error.empty() && !regen::matches( regex, derivation.str() ) )
+                error = "the mutated string does not match the regex";
+            if( !error.empty() )
+            {
+                std::cerr << "Error: mutation " << i << " of node " << node << ": " << error << "\n";
+                ++s_errors;
+                break;
+            }
+        }
+        std::cout << derivation.str() << "\n";
+    }
+    catch( std::exception& ex )
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        ++s_errors;
+    }
+
+    std::cout << std::endl;
+}
+
+/**
+ * checks that the sampling functions give the same strings from generators with the same seed,
+ * and that completions outlive their sampler
+ */
+void testSampler()
+{
+    std::cout << "sampler seeds\n";
+
+    try
+    {
+        std::vector<std::string> runs[2];
+        for( std::vector<std::string>& run : runs )
+        {
+            regen::Generator generator;
+            generator.seed( 7 );
+            for( int i = 0; i < 10; ++i )
+            {
+                run.push_back( regen::generateDifference( R"([a-z]{2,6})", R"(a.*)", 6, generator ) );
+                run.push_back( regen::generateNonMatching( R"([0-9]+)", 6, generator ) );
+                run.push_back( regen::generateWithPrefix( R"(ab[a-z]{1,5})", "abc", 8, generator ) );
+            }
+        }
+        if( runs[0] != runs[1] )
+        {
+            std::cerr << "Error: samplers built from generators with the same seed give different strings\n";
+            ++s_errors;
+        }
+        std::cout << runs[0][0] << " " << runs[0][1] << " " << runs[0][2] << "\n";
+
+        auto tokens = regen::lexer( R"(ab[a-z]{1,5})" );
+        const regen::Re re = regen::Parser().parse( tokens );
+        std::unique_ptr<regen::LanguageSampler> sampler( new regen::LanguageSampler( regen::LanguageSampler::matching( re, 8 ) ) );
+        const regen::LanguageSampler::Completion completion = sampler->complete( "ab" );
+        sampler.reset();
+        if( !regen::matches( R"(ab[a-z]{1,5})", completion.generate() ) )
+        {
+            std::cerr << "Error: the completion of a destroyed sampler does not match the regex\n";
+            ++s_errors;
+        }
+
+        try
+        {
+            regen::LanguageSampler::matching( re, std::numeric_limits<std::size_t>::max() - 1 );
+            std::cerr << "Error: counting strings of any length did not fail\n";
+            ++s_errors;
+        }
+        catch( std::runtime_error& )
+        {
+        }
+    }
+    catch( std::exception& ex )
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        ++s_errors;
+    }
+
+    std::cout << std::endl;
+}
+
+/**
+ * Checks that a packed alternation of literals is not walked as an empty alternation
+ */
+void testPacked()
+{
+    std::cout << "packed alternation\n";
+
+    auto tokens = regen::lexer( R"(alice|bob|carol)" );
+    const regen::Re re = regen::Parser().parse( tokens );
+    if( !re.literals || re.size() != 3 )
+    {
+        std::cerr << "Error: the alternation of literals is not packed\n";
+        ++s_errors;
+    }
+
+    try
+    {
+        re.unionRes();
+        std::cerr << "Error: the alternatives of a packed alternation are readable as an empty vector\n";
+        ++s_errors;
+    }
+    catch( std::logic_error& )
+    {
+    }
+
+    std::cout << std::endl;
+}
+
+/**
+ * Checks that invalid weighted dictionary lines are rejected with their line number
+ */
+void testDictionary()
+{
+    std::cout << "weighted dictionary\n";
+
+    for( const char* text : { "a\t1\n\t3\n", "a\t1\nb\t-1\n", "a\t1\nb\tnan\n", "a\t1\nb\tinf\n" } )
+    {
+        try
+        {
+            regen::Dictionary( "test.tsv", text, nullptr, regen::Dictionary::WEIGHTED );
+            std::cerr << "Error: invalid weighted line accepted in '" << text << "'\n";
+            ++s_errors;
+        }
+        catch( std::runtime_error& ex )
+        {
+            if( std::string( ex.what() ).find( "test.tsv:2:" ) != 0 )
+            {
+                std::cerr << "Error: unexpected error '" << ex.what() << "'\n";
+                ++s_errors;
+            }
+        }
+    }
+
+    std::cout << std::endl;
+}
+
+/**
+ * Checks that the identical sets of the patterns of a library are resolved once
+ */
+void testLibrary()
+{
+    std::cout << "library\n";
+
+    try
+    {
+        regen::ThreadPool pool( 2 );
+        const regen::Library library = regen::compileLibrary( { R"([^a-z]{3})", R"(x[^a-z]+)", R"([^a-z]{3})" }, pool );
+        const regen::Generator::ResolvedSets& first = library.patterns[0]->resolvedSets();
+        const regen::Generator::ResolvedSets& second = library.patterns[1]->resolvedSets();
+        if( &first != &second || first.size() != 1 || library.report.resolvedSets != 1 )
+        {
+            std::cerr << "Error: the identical sets of a library are resolved more than once\n";
+            ++s_errors;
+        }
+
+        const regen::Pattern alone( R"([^a-z]{3})" );
+        std::string strings[2];
+        for( int i = 0; i < 2; ++i )
+        {
+            regen::Pattern pattern = i == 0 ? alone : *library.patterns[2];
+            pattern.seed( 3 );
+            for( int j = 0; j < 10; ++j )
+                pattern.generate( strings[i] );
+        }
+        if( strings[0] != strings[1] )
+        {
+            std::cerr << "Error: a pattern of a library generates other strings than the pattern compiled alone\n";
+            ++s_errors;
+        }
+    }
+    catch( std::exception& ex )
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        ++s_errors;
     }
 
     std::cout << std::endl;
@@ -69,11 +314,22 @@ int main( void )
     test( R"(([A-Z]\w+\s){5,7})" );
     test( R"(([A-Z]\w+\x20){5,7})" );
     test( R"([^a-z]{20})" );
+    test( R"([àâçéèêëîïôûù]{8})" );
+    test( R"([\x{4E00}-\x{9FFF}]{20})" );
 
     test( R"(.+)" );
     test( R"(.+)", 20 );
     test( R"(.+)", 20, 0, R"([A-Z])" );
     test( R"(.+)", 42, 21, R"([A-Z])" );
 
-    return 0;
+    testMutations( R"(([A-Z][a-z]+ )([a-z]+ )+[A-Z][a-z]+\.)", 1000 );
+    testMutations( R"(((ab|c(d|e){0,3})+x|[^a-z]{2,4}|(y(z|é)*)?)+)", 1000 );
+    testMutations( R"([\x{4E00}-\x{9FFF}]{1,3}(foo|bar|baz)*[0-9]?)", 500 );
+
+    testSampler();
+    testPacked();
+    testDictionary();
+    testLibrary();
+
+    return s_errors == 0 ? 0 : 1;
 }
\ No newline at end of file
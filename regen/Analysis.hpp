@@ -0,0 +1,281 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include "Generator.hpp"
+
+namespace regen
+{
+    /**
+     * Static analysis of a regex for the settings of a generator
+     * 
+     * For the whole regex and for each node of its ast, computes what the generated
+     * strings look like without generating any: bounds and expectation of their length,
+     * entropy, number of distinct strings and an estimate of the generation cost.
+     * The expectations assume uniform picks, i.e. no Weighting.
+     */
+    class Analysis
+    {
+    public:
+        struct Stats
+        {
+            /** minimum length in bytes */
+            std::size_t minLength;
+
+            /** maximum length in bytes, saturates at SIZE_MAX */
+            std::size_t maxLength;
+
+            /** expected length in bytes */
+            double expectedLength;
+
+            /** bits of entropy of the generated strings */
+            double entropy;
+
+            /** number of distinct strings, an upper bound as different choices may give the same string */
+            double cardinality;
+
+            /** expected number of ast nodes visited and characters picked */
+            double cost;
+
+            /** worst case number of ast nodes visited and characters picked, @see Budget::maxVisits */
+            double maxCost;
+
+            /** the regex has * + or {n,} repetitions which the generator bounds */
+            bool truncated;
+        };
+
+        /**
+         * analyses a regex
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param generator generator whose settings are analysed
+         */
+        Analysis( const Re& re, const Generator& generator )
+        : m_generator( &generator )
+        {
+            m_stats = analyse( re );
+            m_generator = nullptr;
+        }
+
+        /** @return statistics of the whole regex */
+        const Stats& stats() const { return m_stats; }
+
+        /** @return statistics of a node of the ast */
+        const Stats& stats( const Re& re ) const { return m_nodes.at( &re ); }
+        const Stats& stats( const SimpleRe& sre ) const { return m_nodes.at( &sre ); }
+        const Stats& stats( const BasicRe& bre ) const { return m_nodes.at( &bre ); }
+        const Stats& stats( const ElementaryRe& ere ) const { return m_nodes.at( &ere ); }
+
+    private:
+        static std::size_t add( std::size_t a, std::size_t b )
+        {
+            return a > std::numeric_limits<std::size_t>::max() - b ? std::numeric_limits<std::size_t>::max() : a + b;
+        }
+
+        static std::size_t multiply( std::size_t a, std::size_t b )
+        {
+            return b != 0 && a > std::numeric_limits<std::size_t>::max() / b ? std::numeric_limits<std::size_t>::max() : a * b;
+        }
+
+        const Stats& record( const void* node, const Stats& stats )
+        {
+            return m_nodes[node] = stats;
+        }
+
+        Stats analyse( const Re& re )
+        {
+            Stats res{ std::numeric_limits<std::size_t>::max(), 0, 0, 0, 0, 0, 0, false };
+            const double n = static_cast<double>( re.size() );
+
+            if( re.literals )
+            {
+                for( std::size_t i = 0; i < re.literals->size(); ++i )
+                {
+                    const std::size_t length = (*re.literals)[i].size();
+                    res.minLength = std::min( res.minLength, length );
+                    res.maxLength = std::max( res.maxLength, length );
+                }
+                res.expectedLength = re.literals->data.size() / n;
+                res.cardinality = n;
+                res.cost = 1;
+                res.maxCost = 1;
+            }
+            else for( const SimpleRe& sre : re.unionRes() )
+            {
+                const Stats s = analyse( sre );
+                res.minLength = std::min( res.minLength, s.minLength );
+                res.maxLength = std::max( res.maxLength, s.maxLength );
+                res.expectedLength += s.expectedLength / n;
+                res.entropy += s.entropy / n;
+                res.cardinality += s.cardinality;
+                res.cost += s.cost / n;
+                res.maxCost = std::max( res.maxCost, s.maxCost );
+                res.truncated = res.truncated || s.truncated;
+            }
+
+            res.entropy += std::log2( n );
+            res.cost += 1;
+            res.maxCost += 1;
+
+            return record( &re, res );
+        }
+
+        Stats analyse( const SimpleRe& sre )
+        {
+            Stats res{ 0, 0, 0, 0, 1, 0, 0, false };
+
+            for( const BasicRe& bre : sre.concatRes )
+            {
+                const Stats s = analyse( bre );
+                res.minLength = add( res.minLength, s.minLength );
+                res.maxLength = add( res.maxLength, s.maxLength );
+                res.expectedLength += s.expectedLength;
+                res.entropy += s.entropy;
+                res.cardinality *= s.cardinality;
+                res.cost += s.cost;
+                res.maxCost += s.maxCost;
+                res.truncated = res.truncated || s.truncated;
+            }
+
+            return record( &sre, res );
+        }
+
+        Stats analyse( const BasicRe& bre )
+        {
+            if( auto ptr = dynamic_cast<const ElementaryRe*>( bre.sub.get() ) )
+                return record( &bre, analyse( *ptr ) );
+
+            const ElementaryRe* ere;
+            bool open = false;
+            if( auto ptr = dynamic_cast<const Star*>( bre.sub.get() ) )
+                ere = ptr->re.get(), open = true;
+            else if( auto ptr = dynamic_cast<const Plus*>( bre.sub.get() ) )
+                ere = ptr->re.get(), open = true;
+            else if( auto ptr = dynamic_cast<const Question*>( bre.sub.get() ) )
+                ere = ptr->re.get();
+            else if( auto ptr = dynamic_cast<const NumericRange*>( bre.sub.get() ) )
+                ere = ptr->re.get(), open = ptr->open;
+            else
+                throw std::logic_error( "unknown basic-re type" );
+
+            const auto bounds = m_generator->repetitionBounds( *bre.sub );
+            const Stats s = analyse( *ere );
+
+            const double choices = static_cast<double>( bounds.second - bounds.first + 1 );
+            const double mean = ( static_cast<double>( bounds.first ) + static_cast<double>( bounds.second ) ) / 2;
+
+            // sum of cardinality^n for n in [min, max]
+            double cardinality = 0;
+            if( s.cardinality == 1 || s.maxLength == 0 )
+                cardinality = s.maxLength == 0 ? 1 : choices;
+            else
+            {
+                const double c = s.cardinality;
+                cardinality = std::pow( c, static_cast<double>( bounds.first ) )
+                            * ( std::pow( c, choices ) - 1 ) / ( c - 1 );
+            }
+
+            Stats res;
+            res.minLength = multiply( bounds.first, s.minLength );
+            res.maxLength = multiply( bounds.second, s.maxLength );
+            res.expectedLength = mean * s.expectedLength;
+            res.entropy = std::log2( choices ) + mean * s.entropy;
+            res.cardinality = cardinality;
+            res.cost = 1 + mean * s.cost;
+            res.maxCost = 1 + static_cast<double>( bounds.second ) * s.maxCost;
+            res.truncated = open || s.truncated;
+
+            return record( &bre, res );
+        }
+
+        Stats analyse( const ElementaryRe& ere )
+        {
+            if( auto ptr = dynamic_cast<const Group*>( &ere ) )
+                return record( &ere, analyse( ptr->re ) );
+            if( auto ptr = dynamic_cast<const Any*>( &ere ) )
+                return record( &ere, analyse( m_generator->resolve( *ptr ) ) );
+            if( auto ptr = dynamic_cast<const Char*>( &ere ) )
+            {
+                const std::size_t length = utf8Length( ptr->c );
+                return record( &ere, Stats{ length, length, static_cast<double>( length ), 0, 1, 1, 1, false } );
+            }
+            if( auto ptr = dynamic_cast<const Set*>( &ere ) )
+            {
+                // negated or restricted sets are resolved once, not at each pick (@see Generator::ResolvedSets)
+                return record( &ere, analyse( m_generator->resolve( *ptr ) ) );
+            }
+            if( auto ptr = dynamic_cast<const Reference*>( &ere ) )
+            {
+                const Dictionary& dictionary = m_generator->dictionary( ptr->name );
+                return record( &ere, Stats{ dictionary.minLength(), dictionary.maxLength(), dictionary.expectedLength(), dictionary.entropy(),
+                                            static_cast<double>( dictionary.size() ), 1, 1, false } );
+            }
+
+            throw std::logic_error( "unknown elementary-re type" );
+        }
+
+        Stats analyse( const CharSet& chars ) const
+        {
+            Stats res{ 0, 0, 0, 0, static_cast<double>( chars.size() ), 1, 1, false };
+            if( chars.empty() )
+                return res;
+
+            res.minLength = utf8Length( chars.intervals().front().first );
+            res.maxLength = utf8Length( chars.intervals().back().last );
+            res.entropy = std::log2( static_cast<double>( chars.size() ) );
+
+            // number of code points of each encoded length
+            double bytes = 0;
+            for( const CharSet::Interval& i : chars.intervals() )
+            {
+                char32_t first = i.first;
+                for( char32_t limit : { 0x7Fu, 0x7FFu, 0xFFFFu, 0x10FFFFu } )
+                {
+                    if( first > i.last )
+                        break;
+                    if( first > limit )
+                        continue;
+                    const char32_t last = std::min<char32_t>( i.last, limit );
+                    bytes += static_cast<double>( last - first + 1 ) * utf8Length( first );
+                    first = last + 1;
+                }
+            }
+            res.expectedLength = bytes / chars.size();
+
+            return res;
+        }
+
+        /** only used during the construction */
+        const Generator* m_generator;
+
+        Stats m_stats;
+
+        std::unordered_map<const void*, Stats> m_nodes;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,578 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Parser.hpp"
+#include "Generator.hpp"
+
+namespace regen
+{
+    typedef std::vector<std::pair<unsigned char, unsigned char>> ByteSequence;
+
+    /**
+     * splits the code points [first, last] into sequences of byte ranges
+     * matching exactly their UTF-8 encodings (surrogates are skipped)
+     * 
+     * e.g. [U+0080, U+07FF] is the single sequence [C2-DF][80-BF]
+     * 
+     * @param emit called with each ByteSequence
+     */
+    template<class F>
+    void utf8Sequences( char32_t first, char32_t last, F emit )
+    {
+        if( first <= 0xDFFF && last >= 0xD800 )
+        {
+            if( first < 0xD800 )
+                utf8Sequences( first, 0xD7FF, emit );
+            if( last > 0xDFFF )
+                utf8Sequences( 0xE000, last, emit );
+            return;
+        }
+
+        // split where the length of the encoding changes
+        for( char32_t limit : { 0x7Fu, 0x7FFu, 0xFFFFu } )
+        {
+            if( first <= limit && last > limit )
+            {
+                utf8Sequences( first, limit, emit );
+                utf8Sequences( limit + 1, last, emit );
+                return;
+            }
+        }
+
+        if( last <= 0x7F )
+        {
+            emit( ByteSequence{ { static_cast<unsigned char>( first ), static_cast<unsigned char>( last ) } } );
+            return;
+        }
+
+        // split until every continuation byte spans a whole range
+        for( int i = 1; i < 4; ++i )
+        {
+            const char32_t mask = ( 1u << ( 6 * i ) ) - 1;
+            if( ( first & ~mask ) != ( last & ~mask ) )
+            {
+                if( ( first & mask ) != 0 )
+                {
+                    utf8Sequences( first, first | mask, emit );
+                    utf8Sequences( ( first | mask ) + 1, last, emit );
+                    return;
+                }
+                if( ( last & mask ) != mask )
+                {
+                    utf8Sequences( first, ( last & ~mask ) - 1, emit );
+                    utf8Sequences( last & ~mask, last, emit );
+                    return;
+                }
+            }
+        }
+
+        const std::string lo = toUtf8( first );
+        const std::string hi = toUtf8( last );
+        ByteSequence sequence;
+        for( std::size_t i = 0; i < lo.size(); ++i )
+            sequence.emplace_back( static_cast<unsigned char>( lo[i] ), static_cast<unsigned char>( hi[i] ) );
+        emit( sequence );
+    }
+
+    /**
+     * Thompson NFA matching the UTF-8 encoded strings of the language of a regex
+     * 
+     * The automaton works on bytes. The bytes are partitioned into classes of bytes
+     * which no transition distinguishes, so that a DFA only needs one transition per class.
+     * 
+     * The NFA is not thread safe (it uses scratch space for the closures).
+     */
+    class Nfa
+    {
+    public:
+        struct State
+        {
+            enum EType
+            {
+                RANGE,  // consumes a byte in [lo, hi] and goes to out
+                SPLIT,  // goes to out and out1 without consuming anything
+                MATCH
+            };
+
+            EType type;
+            unsigned char lo;
+            unsigned char hi;
+            std::uint32_t out;
+            std::uint32_t out1;
+        };
+
+        /** sorted set of RANGE and MATCH states */
+        typedef std::vector<std::uint32_t> StateSet;
+
+        enum : std::uint32_t
+        {
+            s_none = 0xFFFFFFFF
+        };
+
+        /**
+         * builds the automaton of a regex
+         * 
+         * @param re regex ast
+         * @param resolve computes the characters matched by a set
+         * @param any characters matched by '.'
+         * @param repetitions computes the bounds of the repetitions of a quantifier,
+         *                    * + and {n,} are unbounded without it
+         * @param maxStates maximum number of states before giving up
+         * 
+         * @throw std::runtime_error the automaton would be larger than maxStates or the regex references a dictionary
+         */
+        Nfa( const Re& re,
+            std::function<CharSet( const Set& )> resolve,
+            const CharSet& any,
+            std::function<std::pair<std::size_t, std::size_t>( const BasicReSub& )> repetitions = nullptr,
+            std::size_t maxStates = 1 << 22 )
+        : m_resolve( resolve ),
+        m_repetitions( repetitions ),
+        m_any( any ),
+        m_maxStates( maxStates )
+        {
+            const std::uint32_t match = newState( State{ State::MATCH, 0, 0, s_none, s_none } );
+            m_start = compile( re, match );
+
+            computeByteClasses();
+            m_marks.assign( m_states.size(), 0 );
+            m_resolve = nullptr;
+            m_repetitions = nullptr;
+        }
+
+        /**
+         * builds the automaton of the language of a regex as std::regex would match it:
+         * * + and {n,} are unbounded, '.' matches anything but line terminators
+         * and negative sets match any code point they do not list
+         */
+        static Nfa regex( const Re& re )
+        {
+            CharSet any = CharSet::all();
+            any = any.difference( CharSet( '\n', '\n' ) ).difference( CharSet( '\r', '\r' ) ).difference( CharSet( 0x2028, 0x2029 ) );
+
+            return Nfa( re,
+                        []( const Set& se ) { return se.negative ? CharSet::all().difference( se.chars ) : se.chars; },
+                        any );
+        }
+
+        /**
+         * builds the automaton of the strings a generator can produce for a regex:
+         * sets and '.' use the generator's characters, the repetitions its bounds
+         * 
+         * @param generator generator whose settings restrict the characters and repetitions
+         * @param boundedRepetitions false to leave * + and {n,} unbounded, e.g. for .*
+         */
+        static Nfa generated( const Re& re, const Generator& generator, bool boundedRepetitions = true )
+        {
+            std::function<std::pair<std::size_t, std::size_t>( const BasicReSub& )> repetitions;
+            if( boundedRepetitions )
+                repetitions = [&generator]( const BasicReSub& quantifier ) { return generator.repetitionBounds( quantifier ); };
+
+            return Nfa( re,
+                        [&generator]( const Set& se ) { return generator.resolve( se ); },
+                        generator.resolve( Any() ),
+                        repetitions );
+        }
+
+        /** @return the set of states before reading anything */
+        StateSet start() const
+        {
+            return closure( { m_start } );
+        }
+
+        /** @return the set of states after reading byte from the given states */
+        StateSet step( const StateSet& states, unsigned char byte ) const
+        {
+            StateSet next;
+            for( std::uint32_t s : states )
+            {
+                const State& st = m_states[s];
+                if( st.type == State::RANGE && st.lo <= byte && byte <= st.hi )
+                    next.push_back( st.out );
+            }
+            return closure( next );
+        }
+
+        /** @return true if the set contains the final state */
+        bool accepts( const StateSet& states ) const
+        {
+            return !states.empty() && m_states[states.front()].type == State::MATCH;
+        }
+
+        /** @return the class of each byte */
+        const std::array<unsigned char, 256>& byteClasses() const { return m_byteClasses; }
+
+        /** @return number of byte classes */
+        std::size_t classCount() const { return m_classes.size(); }
+
+        /** @return the first and last bytes of a class, classes are contiguous */
+        const std::pair<unsigned char, unsigned char>& byteClass( std::size_t c ) const { return m_classes[c]; }
+
+        std::size_t size() const { return m_states.size(); }
+
+    private:
+        std::uint32_t newState( const State& state )
+        {
+            if( m_states.size() >= m_maxStates )
+                throw std::runtime_error( "regex too large to be compiled into an automaton" );
+            m_states.push_back( state );
+            return static_cast<std::uint32_t>( m_states.size() - 1 );
+        }
+
+        std::uint32_t split( std::uint32_t out, std::uint32_t out1 )
+        {
+            return newState( State{ State::SPLIT, 0, 0, out, out1 } );
+        }
+
+        // each compile function builds the automaton of a node followed by next and returns its start
+
+        std::uint32_t compile( const Re& re, std::uint32_t next )
+        {
+            if( re.literals )
+            {
+                std::vector<boost::string_view> literals;
+                literals.reserve( re.literals->size() );
+                for( std::size_t i = 0; i < re.literals->size(); ++i )
+                    literals.push_back( (*re.literals)[i] );
+                std::sort( literals.begin(), literals.end() );
+                return compileTrie( literals, 0, literals.size(), 0, next );
+            }
+
+            const auto& unionRes = re.unionRes();
+            std::uint32_t res = compile( unionRes.back(), next );
+            for( std::size_t i = unionRes.size() - 1; i-- > 0; )
+                res = split( compile( unionRes[i], next ), res );
+            return res;
+        }
+
+        // the literals in [begin, end) are sorted and share their first depth bytes:
+        // each distinct next byte leads to the trie of the literals continuing with it
+        std::uint32_t compileTrie( const std::vector<boost::string_view>& literals, std::size_t begin, std::size_t end, std::size_t depth, std::uint32_t next )
+        {
+            std::vector<std::uint32_t> starts;
+            if( literals[begin].size() == depth )
+                starts.push_back( next );
+            while( begin < end && literals[begin].size() == depth )
+                ++begin;
+
+            while( begin < end )
+            {
+                const unsigned char byte = literals[begin][depth];
+                std::size_t last = begin + 1;
+                while( last < end && static_cast<unsigned char>( literals[last][depth] ) == byte )
+                    ++last;
+
+                const std::uint32_t child = compileTrie( literals, begin, last, depth + 1, next );
+                starts.push_back( newState( State{ State::RANGE, byte, byte, child, s_none } ) );
+                begin = last;
+            }
+
+            std::uint32_t res = starts.back();
+            for( std::size_t i = starts.size() - 1; i-- > 0; )
+                res = split( starts[i], res );
+            return res;
+        }
+
+        std::uint32_t compile( const SimpleRe& sre, std::uint32_t next )
+        {
+            for( auto it = sre.concatRes.rbegin(); it != sre.concatRes.rend(); ++it )
+                next = compile( *it, next );
+            return next;
+        }
+
+        std::uint32_t compile( const BasicRe& bre, std::uint32_t next )
+        {
+            if( m_repetitions && !dynamic_cast<const ElementaryRe*>( bre.sub.get() ) )
+            {
+                const auto bounds = m_repetitions( *bre.sub );
+                return compileRepetition( *quantified( *bre.sub ), bounds.first, bounds.second, false, next );
+            }
+
+            if( auto ptr = dynamic_cast<const Star*>( bre.sub.get() ) )
+                return compileRepetition( *ptr->re, 0, 0, true, next );
+            if( auto ptr = dynamic_cast<const Plus*>( bre.sub.get() ) )
+                return compileRepetition( *ptr->re, 1, 1, true, next );
+            if( auto ptr = dynamic_cast<const Question*>( bre.sub.get() ) )
+                return compileRepetition( *ptr->re, 0, 1, false, next );
+            if( auto ptr = dynamic_cast<const NumericRange*>( bre.sub.get() ) )
+                return compileRepetition( *ptr->re, ptr->min, ptr->max, ptr->open, next );
+            if( auto ptr = dynamic_cast<const ElementaryRe*>( bre.sub.get() ) )
+                return compile( *ptr, next );
+
+            throw std::logic_error( "unknown basic-re type" );
+        }
+
+        std::uint32_t compileRepetition( const ElementaryRe& ere, std::size_t min, std::size_t max, bool open, std::uint32_t next )
+        {
+            std::uint32_t res = next;
+
+            if( open )
+            {
+                // loop: split( ere -> loop, next )
+                const std::uint32_t loop = split( s_none, next );
+                const std::uint32_t body = compile( ere, loop );
+                m_states[loop].out = body;
+                res = loop;
+            }
+            else
+            {
+                // nested optional copies: (e(e(e)?)?)?
+                for( std::size_t i = min; i < max; ++i )
+                    res = split( compile( ere, res ), next );
+            }
+
+            for( std::size_t i = 0; i < min; ++i )
+                res = compile( ere, res );
+
+            return res;
+        }
+
+        std::uint32_t compile( const ElementaryRe& ere, std::uint32_t next )
+        {
+            if( auto ptr = dynamic_cast<const Group*>( &ere ) )
+                return compile( ptr->re, next );
+            if( dynamic_cast<const Any*>( &ere ) )
+                return compile( m_any, next );
+            if( auto ptr = dynamic_cast<const Char*>( &ere ) )
+                return compile( CharSet( ptr->c, ptr->c ), next );
+            if( auto ptr = dynamic_cast<const Set*>( &ere ) )
+                return compile( m_resolve( *ptr ), next );
+            if( auto ptr = dynamic_cast<const Reference*>( &ere ) )
+                throw std::runtime_error( "dictionary reference {" + ptr->name + "} cannot be compiled into an automaton" );
+
+            throw std::logic_error( "unknown elementary-re type" );
+        }
+
+        std::uint32_t compile( const CharSet& chars, std::uint32_t next )
+        {
+            std::vector<std::uint32_t> starts;
+            for( const CharSet::Interval& i : chars.intervals() )
+            {
+                utf8Sequences( i.first, i.last, [&]( const ByteSequence& sequence ) {
+                    std::uint32_t s = next;
+                    for( auto it = sequence.rbegin(); it != sequence.rend(); ++it )
+                        s = newState( State{ State::RANGE, it->first, it->second, s, s_none } );
+                    starts.push_back( s );
+                } );
+            }
+
+            if( starts.empty() ) // matches nothing
+                return newState( State{ State::RANGE, 1, 0, next, s_none } );
+
+            std::uint32_t res = starts.back();
+            for( std::size_t i = starts.size() - 1; i-- > 0; )
+                res = split( starts[i], res );
+            return res;
+        }
+
+        void computeByteClasses()
+        {
+            std::array<bool, 257> boundary{};
+            boundary[0] = true;
+            for( const State& st : m_states )
+            {
+                if( st.type == State::RANGE && st.lo <= st.hi )
+                {
+                    boundary[st.lo] = true;
+                    boundary[st.hi + 1] = true;
+                }
+            }
+
+            for( int b = 0; b < 256; ++b )
+            {
+                if( boundary[b] )
+                    m_classes.emplace_back( static_cast<unsigned char>( b ), static_cast<unsigned char>( b ) );
+                m_classes.back().second = static_cast<unsigned char>( b );
+                m_byteClasses[b] = static_cast<unsigned char>( m_classes.size() - 1 );
+            }
+        }
+
+        /**
+         * @return the RANGE and MATCH states reachable from the given states
+         *         without consuming anything, sorted with MATCH first
+         */
+        StateSet closure( StateSet stack ) const
+        {
+            if( ++m_generation == 0 )
+            {
+                std::fill( m_marks.begin(), m_marks.end(), 0 );
+                m_generation = 1;
+            }
+
+            StateSet res;
+            while( !stack.empty() )
+            {
+                const std::uint32_t s = stack.back();
+                stack.pop_back();
+                if( m_marks[s] == m_generation )
+                    continue;
+                m_marks[s] = m_generation;
+
+                const State& st = m_states[s];
+                if( st.type == State::SPLIT )
+                {
+                    stack.push_back( st.out1 );
+                    stack.push_back( st.out );
+                }
+                else
+                    res.push_back( s );
+            }
+
+            // the MATCH state is state 0, so it comes first
+            std::sort( res.begin(), res.end() );
+            return res;
+        }
+
+        std::vector<State> m_states;
+        std::uint32_t m_start;
+
+        /** only used during the construction */
+        std::function<CharSet( const Set& )> m_resolve;
+        std::function<std::pair<std::size_t, std::size_t>( const BasicReSub& )> m_repetitions;
+        CharSet m_any;
+        std::size_t m_maxStates;
+
+        std::array<unsigned char, 256> m_byteClasses;
+        std::vector<std::pair<unsigned char, unsigned char>> m_classes;
+
+        /** scratch space for the closures */
+        mutable std::vector<std::uint32_t> m_marks;
+        mutable std::uint32_t m_generation = 0;
+    };
+
+    /**
+     * DFA of the strings matched by an NFA and not by another one
+     * 
+     * The automaton is fully built upfront, with one transition per class of bytes
+     * distinguished by either NFA. State 0 is the dead state and state 1 the start.
+     */
+    class Dfa
+    {
+    public:
+        enum : std::int32_t
+        {
+            s_dead = 0,
+            s_start = 1
+        };
+
+        /**
+         * @param nfa strings accepted by the DFA
+         * @param excluded optional strings removed from the language of nfa
+         * @param maxStates maximum number of states before giving up
+         * 
+         * @throw std::runtime_error the DFA would have more than maxStates states
+         */
+        explicit Dfa( const Nfa& nfa, const Nfa* excluded = nullptr, std::size_t maxStates = 1 << 16 )
+        {
+            // bytes are in the same class if they are for both automata
+            for( int b = 0; b < 256; ++b )
+            {
+                if( b == 0 || nfa.byteClasses()[b] != nfa.byteClasses()[b-1]
+                    || ( excluded && excluded->byteClasses()[b] != excluded->byteClasses()[b-1] ) )
+                    m_classes.emplace_back( static_cast<unsigned char>( b ), static_cast<unsigned char>( b ) );
+                m_classes.back().second = static_cast<unsigned char>( b );
+                m_byteClasses[b] = static_cast<unsigned char>( m_classes.size() - 1 );
+            }
+
+            typedef std::pair<Nfa::StateSet, Nfa::StateSet> Key;
+            std::map<Key, std::int32_t> ids;
+            std::vector<Key> states;
+
+            auto add = [&]( Key&& key ) -> std::int32_t {
+                // nothing can be accepted once the first automaton is stuck
+                if( key.first.empty() )
+                    return s_dead;
+
+                auto it = ids.find( key );
+                if( it != ids.end() )
+                    return it->second;
+
+                if( states.size() >= maxStates )
+                    throw std::runtime_error( "regex too large to be compiled into a DFA" );
+
+                const std::int32_t id = static_cast<std::int32_t>( states.size() );
+                m_accepting.push_back( nfa.accepts( key.first ) && !( excluded && excluded->accepts( key.second ) ) );
+                ids.emplace( key, id );
+                states.push_back( std::move( key ) );
+                return id;
+            };
+
+            states.emplace_back();
+            m_accepting.push_back( false );
+            add( Key( nfa.start(), excluded ? excluded->start() : Nfa::StateSet() ) );
+
+            for( std::size_t s = 1; s < states.size(); ++s )
+            {
+                for( std::size_t c = 0; c < m_classes.size(); ++c )
+                {
+                    const unsigned char byte = m_classes[c].first;
+                    Key next( nfa.step( states[s].first, byte ),
+                              excluded ? excluded->step( states[s].second, byte ) : Nfa::StateSet() );
+                    m_transitions.push_back( add( std::move( next ) ) );
+                }
+            }
+
+            // transitions of the dead state
+            m_transitions.insert( m_transitions.begin(), m_classes.size(), s_dead );
+        }
+
+        std::int32_t next( std::int32_t state, unsigned char byte ) const
+        {
+            return m_transitions[state * m_classes.size() + m_byteClasses[byte]];
+        }
+
+        std::int32_t nextByClass( std::int32_t state, std::size_t cls ) const
+        {
+            return m_transitions[state * m_classes.size() + cls];
+        }
+
+        bool accepting( std::int32_t state ) const { return m_accepting[state]; }
+
+        /** @return number of states, including the dead state */
+        std::size_t size() const { return m_accepting.size(); }
+
+        std::size_t classCount() const { return m_classes.size(); }
+
+        /** @return the first and last bytes of a class, classes are contiguous */
+        const std::pair<unsigned char, unsigned char>& byteClass( std::size_t c ) const { return m_classes[c]; }
+
+    private:
+        std::array<unsigned char, 256> m_byteClasses;
+        std::vector<std::pair<unsigned char, unsigned char>> m_classes;
+
+        /** m_transitions[state * classCount() + class] */
+        std::vector<std::int32_t> m_transitions;
+        std::vector<bool> m_accepting;
+    };
+}
\ No newline at end of file
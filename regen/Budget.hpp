@@ -0,0 +1,90 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace regen
+{
+    /**
+     * Limits of the resources a generation may use, to guard against pathological patterns
+     * e.g. nested quantifiers like ((a{1000}){1000}){1000}
+     * 
+     * The defaults are unlimited.
+     * 
+     * @see Generator::generate( const Re&, std::string&, const Budget& )
+     */
+    struct Budget
+    {
+        /** maximum number of bytes generated */
+        std::size_t maxBytes = std::numeric_limits<std::size_t>::max();
+
+        /** maximum number of ast nodes visited */
+        std::size_t maxVisits = std::numeric_limits<std::size_t>::max();
+
+        /** time after which the generation is aborted */
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+        /**
+         * @return an unlimited budget, except for a deadline after the given duration from now
+         */
+        template<class Rep, class Period>
+        static Budget timeout( std::chrono::duration<Rep, Period> duration )
+        {
+            Budget res;
+            res.deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>( duration );
+            return res;
+        }
+    };
+
+    /**
+     * Thrown when a generation exceeds its budget, or when a pattern could exceed it
+     */
+    class BudgetExceeded : public std::runtime_error
+    {
+    public:
+        enum EResource
+        {
+            BYTES,
+            VISITS,
+            TIME
+        };
+
+        BudgetExceeded( EResource resource, const std::string& what )
+        : std::runtime_error( what ),
+        m_resource( resource )
+        {
+        }
+
+        /** @return the resource which exceeded the budget */
+        EResource resource() const { return m_resource; }
+
+    private:
+        EResource m_resource;
+    };
+}
\ No newline at end of file
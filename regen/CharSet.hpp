@@ -0,0 +1,361 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace regen
+{
+    /** highest valid unicode code point */
+    const char32_t s_maxCodePoint = 0x10FFFF;
+
+    /**
+     * appends the UTF-8 encoding of a code point to a string
+     * 
+     * @param out string to append to
+     * @param cp code point to encode
+     */
+    inline void appendUtf8( std::string& out, char32_t cp )
+    {
+        if( cp < 0x80 )
+        {
+            out += static_cast<char>( cp );
+        }
+        else if( cp < 0x800 )
+        {
+            out += static_cast<char>( 0xC0 | ( cp >> 6 ) );
+            out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+        }
+        else if( cp < 0x10000 )
+        {
+            out += static_cast<char>( 0xE0 | ( cp >> 12 ) );
+            out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+            out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+        }
+        else
+        {
+            out += static_cast<char>( 0xF0 | ( cp >> 18 ) );
+            out += static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+            out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+            out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+        }
+    }
+
+    /**
+     * encodes a code point in UTF-8 into a buffer
+     * 
+     * @param cp code point to encode
+     * @param out buffer with room for 4 bytes
+     * 
+     * @return number of bytes written
+     */
+    inline std::size_t writeUtf8( char32_t cp, char* out )
+    {
+        if( cp < 0x80 )
+        {
+            out[0] = static_cast<char>( cp );
+            return 1;
+        }
+        if( cp < 0x800 )
+        {
+            out[0] = static_cast<char>( 0xC0 | ( cp >> 6 ) );
+            out[1] = static_cast<char>( 0x80 | ( cp & 0x3F ) );
+            return 2;
+        }
+        if( cp < 0x10000 )
+        {
+            out[0] = static_cast<char>( 0xE0 | ( cp >> 12 ) );
+            out[1] = static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+            out[2] = static_cast<char>( 0x80 | ( cp & 0x3F ) );
+            return 3;
+        }
+        out[0] = static_cast<char>( 0xF0 | ( cp >> 18 ) );
+        out[1] = static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+        out[2] = static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+        out[3] = static_cast<char>( 0x80 | ( cp & 0x3F ) );
+        return 4;
+    }
+
+    /**
+     * @return the UTF-8 encoding of a code point
+     */
+    inline std::string toUtf8( char32_t cp )
+    {
+        std::string res;
+        appendUtf8( res, cp );
+        return res;
+    }
+
+    /**
+     * @return number of bytes in the UTF-8 encoding of a code point
+     */
+    inline std::size_t utf8Length( char32_t cp )
+    {
+        return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+    }
+
+    /**
+     * decodes the UTF-8 sequence starting at str[i] and advances i past it
+     * 
+     * @throw std::runtime_error invalid UTF-8 sequence
+     * 
+     * @return the decoded code point
+     */
+    inline char32_t readUtf8( const std::string& str, std::size_t& i )
+    {
+        const unsigned char lead = static_cast<unsigned char>( str[i] );
+
+        std::size_t length;
+        char32_t cp;
+        if( lead < 0x80 )
+        {
+            ++i;
+            return lead;
+        }
+        else if( ( lead & 0xE0 ) == 0xC0 )
+        {
+            length = 2;
+            cp = lead & 0x1F;
+        }
+        else if( ( lead & 0xF0 ) == 0xE0 )
+        {
+            length = 3;
+            cp = lead & 0x0F;
+        }
+        else if( ( lead & 0xF8 ) == 0xF0 )
+        {
+            length = 4;
+            cp = lead & 0x07;
+        }
+        else
+            throw std::runtime_error( "Invalid UTF-8 sequence at offset " + std::to_string( i ) );
+
+        if( i + length > str.size() )
+            throw std::runtime_error( "Truncated UTF-8 sequence at offset " + std::to_string( i ) );
+
+        for( std::size_t k = 1; k < length; ++k )
+        {
+            const unsigned char cont = static_cast<unsigned char>( str[i+k] );
+            if( ( cont & 0xC0 ) != 0x80 )
+                throw std::runtime_error( "Invalid UTF-8 sequence at offset " + std::to_string( i ) );
+            cp = ( cp << 6 ) | ( cont & 0x3F );
+        }
+
+        if( utf8Length( cp ) != length || cp > s_maxCodePoint || ( cp >= 0xD800 && cp <= 0xDFFF ) )
+            throw std::runtime_error( "Invalid UTF-8 sequence at offset " + std::to_string( i ) );
+
+        i += length;
+        return cp;
+    }
+
+    /**
+     * Set of unicode code points
+     * 
+     * stored as a sorted list of disjoint intervals along with the number of
+     * code points preceding each interval, so that the n-th code point of the
+     * set can be found with a binary search instead of expanding the set.
+     */
+    class CharSet
+    {
+    public:
+        struct Interval
+        {
+            char32_t first;
+            char32_t last;
+        };
+
+        CharSet() = default;
+
+        CharSet( char32_t first, char32_t last )
+        {
+            insert( first, last );
+        }
+
+        /**
+         * @return the set of all valid code points (surrogates excluded)
+         */
+        static CharSet all()
+        {
+            CharSet res( 0, 0xD7FF );
+            res.insert( 0xE000, s_maxCodePoint );
+            return res;
+        }
+
+        /**
+         * adds the code points [first, last] to the set
+         */
+        void insert( char32_t first, char32_t last )
+        {
+            if( last < first )
+                throw std::logic_error( "invalid code point interval" );
+
+            // find the intervals overlapping or adjacent to [first, last] and merge them
+            auto lo = std::lower_bound( m_intervals.begin(), m_intervals.end(), first,
+                            []( const Interval& i, char32_t c ) { return i.last + 1 < c; } );
+            auto hi = lo;
+            while( hi != m_intervals.end() && hi->first <= last + 1 )
+            {
+                first = std::min( first, hi->first );
+                last = std::max( last, hi->last );
+                ++hi;
+            }
+
+            lo = m_intervals.erase( lo, hi );
+            m_intervals.insert( lo, Interval{ first, last } );
+
+            updateOffsets();
+        }
+
+        /**
+         * adds all the code points of another set to this one
+         */
+        void insert( const CharSet& other )
+        {
+            for( const Interval& i : other.m_intervals )
+                insert( i.first, i.last );
+        }
+
+        /**
+         * @return code points in this set which are not in the other set
+         */
+        CharSet difference( const CharSet& other ) const
+        {
+            CharSet res;
+
+            auto it = other.m_intervals.begin();
+            for( const Interval& i : m_intervals )
+            {
+                char32_t first = i.first;
+
+                while( it != other.m_intervals.end() && it->last < first )
+                    ++it;
+
+                auto cut = it;
+                bool exhausted = false;
+                while( cut != other.m_intervals.end() && cut->first <= i.last )
+                {
+                    if( cut->first > first )
+                        res.m_intervals.push_back( Interval{ first, cut->first - 1 } );
+                    if( cut->last >= i.last )
+                    {
+                        exhausted = true;
+                        break;
+                    }
+                    first = cut->last + 1;
+                    ++cut;
+                }
+
+                if( !exhausted )
+                    res.m_intervals.push_back( Interval{ first, i.last } );
+            }
+
+            res.updateOffsets();
+            return res;
+        }
+
+        /**
+         * @return code points which are both in this set and in the other set
+         */
+        CharSet intersection( const CharSet& other ) const
+        {
+            CharSet res;
+
+            auto a = m_intervals.begin();
+            auto b = other.m_intervals.begin();
+            while( a != m_intervals.end() && b != other.m_intervals.end() )
+            {
+                const char32_t first = std::max( a->first, b->first );
+                const char32_t last = std::min( a->last, b->last );
+                if( first <= last )
+                    res.m_intervals.push_back( Interval{ first, last } );
+
+                if( a->last < b->last )
+                    ++a;
+                else
+                    ++b;
+            }
+
+            res.updateOffsets();
+            return res;
+        }
+
+        bool contains( char32_t c ) const
+        {
+            auto it = std::upper_bound( m_intervals.begin(), m_intervals.end(), c,
+                            []( char32_t c, const Interval& i ) { return c < i.first; } );
+            return it != m_intervals.begin() && ( it - 1 )->last >= c;
+        }
+
+        /**
+         * @return the n-th code point of the set, in increasing order
+         */
+        char32_t operator[]( std::size_t n ) const
+        {
+            auto it = std::upper_bound( m_offsets.begin(), m_offsets.end(), n );
+            const std::size_t i = it - m_offsets.begin() - 1;
+            return m_intervals[i].first + static_cast<char32_t>( n - m_offsets[i] );
+        }
+
+        /** @return number of code points in the set */
+        std::size_t size() const { return m_size; }
+
+        bool empty() const { return m_size == 0; }
+
+        const std::vector<Interval>& intervals() const { return m_intervals; }
+
+        bool operator==( const CharSet& other ) const
+        {
+            return m_intervals.size() == other.m_intervals.size()
+                && std::equal( m_intervals.begin(), m_intervals.end(), other.m_intervals.begin(),
+                            []( const Interval& a, const Interval& b ) { return a.first == b.first && a.last == b.last; } );
+        }
+
+        bool operator!=( const CharSet& other ) const { return !( *this == other ); }
+
+    private:
+        void updateOffsets()
+        {
+            m_offsets.resize( m_intervals.size() );
+            m_size = 0;
+            for( std::size_t i = 0; i < m_intervals.size(); ++i )
+            {
+                m_offsets[i] = m_size;
+                m_size += m_intervals[i].last - m_intervals[i].first + 1;
+            }
+        }
+
+        /** sorted, disjoint and non adjacent intervals */
+        std::vector<Interval> m_intervals;
+
+        /** m_offsets[i] is the number of code points in the intervals before m_intervals[i] */
+        std::vector<std::size_t> m_offsets;
+
+        /** total number of code points */
+        std::size_t m_size = 0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,482 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "Generator.hpp"
+
+namespace regen
+{
+    /**
+     * Small set of strings which together exercise every part of a regex, for conformance tests
+     * 
+     * The goals to cover are:
+     * - every alternative of every union
+     * - the endpoints of the ranges of every set and '.'
+     * - the min and max number of repetitions of every quantifier
+     * - optionally, the pairs of choices of sibling nodes of a concatenation: alternatives of
+     *   groups, min or max repetitions of quantifiers and first or last characters of sets
+     * 
+     * The strings are computed from the ast, without randomness: each string is built by
+     * a walk of the ast which prefers the choices leading to uncovered goals, until a walk
+     * covers no new goal. This greedy cover is not minimal but is close in practice.
+     */
+    class Coverage
+    {
+    public:
+        struct Count
+        {
+            std::size_t total;
+            std::size_t covered;
+        };
+
+        struct Report
+        {
+            Count alternatives;
+            Count endpoints;
+            Count bounds;
+            Count pairs;
+
+            /** @return ratio of covered goals in [0, 1] */
+            double ratio() const
+            {
+                const std::size_t total = alternatives.total + endpoints.total + bounds.total + pairs.total;
+                const std::size_t covered = alternatives.covered + endpoints.covered + bounds.covered + pairs.covered;
+                return total == 0 ? 1 : static_cast<double>( covered ) / total;
+            }
+        };
+
+        /**
+         * computes the covering strings of a regex
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param generator generator whose settings bound the repetitions and restrict the characters
+         * @param pairwise also cover the pairs of choices of sibling nodes
+         * 
+         * @throw std::runtime_error a character must be generated from an empty set
+         */
+        Coverage( const Re& re, const Generator& generator = Generator(), bool pairwise = false )
+        : m_generator( &generator ),
+        m_pairwise( pairwise )
+        {
+            index( re );
+            m_covered.assign( m_kinds.size(), false );
+
+            for( ;; )
+            {
+                const std::size_t before = coveredCount();
+                std::string str;
+                walk( re, str, -1 );
+                if( coveredCount() == before )
+                    break;
+                m_strings.push_back( std::move( str ) );
+            }
+
+            if( m_strings.empty() )
+            {
+                // nothing to cover, a single string exercises the regex
+                std::string str;
+                walk( re, str, -1 );
+                m_strings.push_back( std::move( str ) );
+            }
+
+            m_generator = nullptr;
+        }
+
+        /** @return the covering strings (UTF-8 encoded) */
+        const std::vector<std::string>& strings() const { return m_strings; }
+
+        /** @return the goals covered by the strings */
+        Report report() const
+        {
+            Report res{ { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+            for( std::size_t i = 0; i < m_kinds.size(); ++i )
+            {
+                Count& count = m_kinds[i] == ALTERNATIVE ? res.alternatives
+                             : m_kinds[i] == ENDPOINT ? res.endpoints
+                             : m_kinds[i] == BOUND ? res.bounds
+                             : res.pairs;
+                ++count.total;
+                if( m_covered[i] )
+                    ++count.covered;
+            }
+            return res;
+        }
+
+    private:
+        enum EKind
+        {
+            ALTERNATIVE,
+            ENDPOINT,
+            BOUND,
+            PAIR
+        };
+
+        /** goals of a node of the ast */
+        struct Info
+        {
+            /** goals of the subtree */
+            std::size_t begin = 0;
+            std::size_t end = 0;
+
+            /** first goal of the node itself */
+            std::size_t goal = 0;
+
+            /** Set and Any: the characters and the endpoints of their ranges */
+            CharSet chars;
+            std::vector<char32_t> endpoints;
+
+            /** quantifier: bounds of the repetition */
+            std::size_t min = 0;
+            std::size_t max = 0;
+
+            /** SimpleRe: number of choices of each sibling and first goal of the pairs of siblings i < j at i * n + j */
+            std::vector<std::size_t> options;
+            std::vector<std::size_t> pairs;
+        };
+
+        std::size_t addGoals( EKind kind, std::size_t count )
+        {
+            const std::size_t first = m_kinds.size();
+            m_kinds.insert( m_kinds.end(), count, kind );
+            return first;
+        }
+
+        void index( const Re& re )
+        {
+            Info& info = m_info[&re];
+            info.begin = m_kinds.size();
+            if( re.size() > 1 )
+                info.goal = addGoals( ALTERNATIVE, re.size() );
+            if( !re.literals )
+                for( const SimpleRe& sre : re.unionRes() )
+                    index( sre );
+            m_info[&re].end = m_kinds.size();
+        }
+
+        void index( const SimpleRe& sre )
+        {
+            Info info;
+            info.begin = m_kinds.size();
+
+            if( m_pairwise )
+            {
+                const std::size_t n = sre.concatRes.size();
+                for( const BasicRe& bre : sre.concatRes )
+                    info.options.push_back( options( bre ) );
+
+                info.pairs.assign( n * n, 0 );
+                for( std::size_t i = 0; i < n; ++i )
+                    for( std::size_t j = i + 1; j < n; ++j )
+                        if( info.options[i] > 1 && info.options[j] > 1 )
+                            info.pairs[i * n + j] = addGoals( PAIR, info.options[i] * info.options[j] );
+            }
+
+            for( const BasicRe& bre : sre.concatRes )
+                index( bre );
+
+            info.end = m_kinds.size();
+            m_info[&sre] = std::move( info );
+        }
+
+        void index( const BasicRe& bre )
+        {
+            Info info;
+            info.begin = m_kinds.size();
+
+            const ElementaryRe* ere = dynamic_cast<const ElementaryRe*>( bre.sub.get() );
+            if( !ere )
+            {
+                const auto bounds = m_generator->repetitionBounds( *bre.sub );
+                info.min = bounds.first;
+                info.max = bounds.second;
+                info.goal = addGoals( BOUND, bounds.first == bounds.second ? 1 : 2 );
+                ere = quantified( *bre.sub );
+            }
+            index( *ere );
+
+            info.end = m_kinds.size();
+            m_info[&bre] = std::move( info );
+        }
+
+        void index( const ElementaryRe& ere )
+        {
+            // a node shared by several places of the ast (@see Interner) has the same goals everywhere
+            if( m_info.count( &ere ) )
+                return;
+
+            if( auto ptr = dynamic_cast<const Group*>( &ere ) )
+            {
+                index( ptr->re );
+                m_info[&ere] = m_info[&ptr->re];
+                return;
+            }
+
+            Info info;
+            info.begin = m_kinds.size();
+            if( auto ptr = dynamic_cast<const Set*>( &ere ) )
+                info.chars = m_generator->resolve( *ptr );
+            else if( auto ptr = dynamic_cast<const Any*>( &ere ) )
+                info.chars = m_generator->resolve( *ptr );
+
+            for( const CharSet::Interval& i : info.chars.intervals() )
+            {
+                info.endpoints.push_back( i.first );
+                if( i.last != i.first )
+                    info.endpoints.push_back( i.last );
+            }
+            if( info.endpoints.size() > 1 )
+                info.goal = addGoals( ENDPOINT, info.endpoints.size() );
+            else
+                info.endpoints.clear();
+
+            info.end = m_kinds.size();
+            m_info[&ere] = std::move( info );
+        }
+
+        /**
+         * @return number of choices of a node for the pairwise coverage, 0 if it has no choice
+         */
+        std::size_t options( const BasicRe& bre ) const
+        {
+            if( auto ere = dynamic_cast<const ElementaryRe*>( bre.sub.get() ) )
+            {
+                if( auto ptr = dynamic_cast<const Group*>( ere ) )
+                    return ptr->re.size() > 1 ? ptr->re.size() : 0;
+                if( auto ptr = dynamic_cast<const Set*>( ere ) )
+                    return m_generator->resolve( *ptr ).size() > 1 ? 2 : 0;
+                if( auto ptr = dynamic_cast<const Any*>( ere ) )
+                    return m_generator->resolve( *ptr ).size() > 1 ? 2 : 0;
+                return 0;
+            }
+
+            const auto bounds = m_generator->repetitionBounds( *bre.sub );
+            return bounds.first != bounds.second ? 2 : 0;
+        }
+
+        bool uncovered( const Info& info ) const
+        {
+            for( std::size_t i = info.begin; i < info.end; ++i )
+                if( !m_covered[i] )
+                    return true;
+            return false;
+        }
+
+        std::size_t coveredCount() const
+        {
+            return static_cast<std::size_t>( std::count( m_covered.begin(), m_covered.end(), true ) );
+        }
+
+        /**
+         * appends a string of re, preferring the uncovered goals
+         * 
+         * @param forced alternative to take, -1 to choose
+         * 
+         * @return the alternative taken
+         */
+        int walk( const Re& re, std::string& out, int forced )
+        {
+            const Info& info = m_info.at( &re );
+            std::size_t alternative = 0;
+            if( forced >= 0 )
+            {
+                alternative = static_cast<std::size_t>( forced );
+            }
+            else if( re.size() > 1 )
+            {
+                // an uncovered alternative, else one leading to uncovered goals
+                alternative = re.size();
+                for( std::size_t i = 0; i < re.size() && alternative == re.size(); ++i )
+                    if( !m_covered[info.goal + i] )
+                        alternative = i;
+                for( std::size_t i = 0; !re.literals && i < re.size() && alternative == re.size(); ++i )
+                    if( uncovered( m_info.at( &re.unionRes()[i] ) ) )
+                        alternative = i;
+                if( alternative == re.size() )
+                    alternative = 0;
+            }
+
+            if( re.size() > 1 )
+                m_covered[info.goal + alternative] = true;
+
+            if( re.literals )
+            {
+                const boost::string_view literal = (*re.literals)[alternative];
+                out.append( literal.data(), literal.size() );
+            }
+            else
+            {
+                walk( re.unionRes()[alternative], out );
+            }
+            return static_cast<int>( alternative );
+        }
+
+        void walk( const SimpleRe& sre, std::string& out )
+        {
+            const Info& info = m_info.at( &sre );
+            const std::size_t n = sre.concatRes.size();
+            std::vector<int> taken( n, -1 );
+
+            for( std::size_t j = 0; j < n; ++j )
+            {
+                int forced = -1;
+                if( m_pairwise && info.options[j] > 1 )
+                {
+                    // the choice completing the most uncovered pairs with the previous siblings,
+                    // then appearing in the most uncovered pairs with the next ones
+                    std::pair<std::size_t, std::size_t> best( 0, 0 );
+                    for( std::size_t o = 0; o < info.options[j]; ++o )
+                    {
+                        std::pair<std::size_t, std::size_t> count( 0, 0 );
+                        for( std::size_t i = 0; i < j; ++i )
+                            if( info.options[i] > 1 && taken[i] >= 0
+                                && !m_covered[info.pairs[i * n + j] + taken[i] * info.options[j] + o] )
+                                ++count.first;
+                        for( std::size_t k = j + 1; k < n; ++k )
+                            for( std::size_t p = 0; info.options[k] > 1 && p < info.options[k]; ++p )
+                                if( !m_covered[info.pairs[j * n + k] + o * info.options[k] + p] )
+                                    ++count.second;
+                        if( count > best )
+                            best = count, forced = static_cast<int>( o );
+                    }
+                }
+
+                taken[j] = walk( sre.concatRes[j], out, forced );
+            }
+
+            if( m_pairwise )
+                for( std::size_t i = 0; i < n; ++i )
+                    for( std::size_t j = i + 1; j < n; ++j )
+                        if( info.options[i] > 1 && info.options[j] > 1 && taken[i] >= 0 && taken[j] >= 0 )
+                            m_covered[info.pairs[i * n + j] + taken[i] * info.options[j] + taken[j]] = true;
+        }
+
+        /**
+         * @param forced choice to take (@see options), -1 to choose
+         * 
+         * @return the choice taken, -1 if it is not one of the options
+         */
+        int walk( const BasicRe& bre, std::string& out, int forced )
+        {
+            if( auto ere = dynamic_cast<const ElementaryRe*>( bre.sub.get() ) )
+                return walk( *ere, out, forced );
+
+            const Info& info = m_info.at( &bre );
+            const ElementaryRe& ere = *quantified( *bre.sub );
+            const bool minUncovered = !m_covered[info.goal];
+            const bool maxUncovered = info.min != info.max && !m_covered[info.goal + 1];
+
+            std::size_t count;
+            if( forced >= 0 )
+                count = forced == 0 ? info.min : info.max;
+            else if( uncovered( m_info.at( &ere ) ) )
+                count = maxUncovered ? info.max : std::max<std::size_t>( info.min, 1 );
+            else if( minUncovered )
+                count = info.min;
+            else if( maxUncovered )
+                count = info.max;
+            else
+                count = info.min;
+            count = std::min( std::max( count, info.min ), info.max );
+
+            if( count == info.min )
+                m_covered[info.goal] = true;
+            if( count == info.max && info.min != info.max )
+                m_covered[info.goal + 1] = true;
+
+            for( std::size_t i = 0; i < count; ++i )
+                walk( ere, out, -1 );
+
+            if( info.min == info.max )
+                return -1;
+            return count == info.min ? 0 : count == info.max ? 1 : -1;
+        }
+
+        int walk( const ElementaryRe& ere, std::string& out, int forced )
+        {
+            if( auto ptr = dynamic_cast<const Group*>( &ere ) )
+                return walk( ptr->re, out, forced );
+            if( auto ptr = dynamic_cast<const Char*>( &ere ) )
+            {
+                appendUtf8( out, ptr->c );
+                return -1;
+            }
+            if( auto ptr = dynamic_cast<const Reference*>( &ere ) )
+            {
+                // the words of a dictionary are not goals
+                const boost::string_view word = m_generator->dictionary( ptr->name )[0];
+                out.append( word.data(), word.size() );
+                return -1;
+            }
+
+            const Info& info = m_info.at( &ere );
+            if( info.chars.empty() )
+                throw std::runtime_error( "no character can be generated from an empty set" );
+
+            char32_t c = info.chars[0];
+            if( forced >= 0 )
+            {
+                c = forced == 0 ? info.chars[0] : info.chars[info.chars.size() - 1];
+            }
+            else
+            {
+                for( std::size_t i = 0; i < info.endpoints.size(); ++i )
+                {
+                    if( !m_covered[info.goal + i] )
+                    {
+                        c = info.endpoints[i];
+                        break;
+                    }
+                }
+            }
+
+            for( std::size_t i = 0; i < info.endpoints.size(); ++i )
+                if( info.endpoints[i] == c )
+                    m_covered[info.goal + i] = true;
+
+            appendUtf8( out, c );
+
+            if( c == info.chars[0] )
+                return 0;
+            return c == info.chars[info.chars.size() - 1] ? 1 : -1;
+        }
+
+        /** only used during the construction */
+        const Generator* m_generator;
+        bool m_pairwise;
+
+        /** kind of each goal, and whether it is covered */
+        std::vector<EKind> m_kinds;
+        std::vector<bool> m_covered;
+
+        std::unordered_map<const void*, Info> m_info;
+
+        std::vector<std::string> m_strings;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace regen
+{
+    class Generator;
+
+    /**
+     * Record of the choices made while generating a string
+     * 
+     * Each node records a choice and the part of the string it generated:
+     * - UNION: the alternative picked for a Re
+     * - REPETITION: the number of repetitions picked for a quantifier
+     * - ELEMENT: an elementary regex (group, char, set or '.'), with the code point picked for a set or '.'
+     * 
+     * Nodes are stored in pre-order in a flat vector, the descendants of node i
+     * are the nodes in ]i, end( i )[. A node only records its position relative to its parent,
+     * so regenerating a subtree updates its ancestors and their following siblings,
+     * not every node after it.
+     * 
+     * @see Generator::generate( const Re&, Derivation& )
+     * @see Generator::mutate
+     */
+    class Derivation
+    {
+    public:
+        struct Node
+        {
+            enum EType
+            {
+                UNION,
+                REPETITION,
+                ELEMENT
+            };
+
+            EType type;
+
+            /** const Re*, const BasicReSub* (the quantifier) or const ElementaryRe* */
+            const void* ast;
+
+            /** distance to the parent node, 0 for the root (@see Derivation::parent) */
+            std::uint32_t parent;
+
+            /** number of nodes of the subtree, the node included (@see Derivation::end) */
+            std::uint32_t size;
+
+            /** generated part of the string, begin is relative to the begin of the parent (@see Derivation::begin) */
+            std::size_t begin;
+            std::size_t length;
+
+            /** alternative, number of repetitions or code point */
+            std::uint32_t choice;
+        };
+
+        enum : std::uint32_t
+        {
+            s_root = 0xFFFFFFFF
+        };
+
+        /** @return the generated string */
+        const std::string& str() const { return m_str; }
+
+        const std::vector<Node>& nodes() const { return m_nodes; }
+
+        const Node& operator[]( std::size_t i ) const { return m_nodes[i]; }
+
+        std::size_t size() const { return m_nodes.size(); }
+
+        /** @return index of the parent of a node, s_root for the root */
+        std::size_t parent( std::size_t node ) const
+        {
+            return m_nodes[node].parent == 0 ? static_cast<std::size_t>( s_root ) : node - m_nodes[node].parent;
+        }
+
+        /** @return index past the last node of the subtree of a node */
+        std::size_t end( std::size_t node ) const
+        {
+            return node + m_nodes[node].size;
+        }
+
+        /** @return position in the string of the part a node generated, in O(depth of the node) */
+        std::size_t begin( std::size_t node ) const
+        {
+            std::size_t res = 0;
+            for( std::size_t n = node; n != s_root; n = parent( n ) )
+                res += m_nodes[n].begin;
+            return res;
+        }
+
+    private:
+        friend class Generator;
+
+        void clear()
+        {
+            m_str.clear();
+            m_nodes.clear();
+            m_begins.clear();
+            m_current = s_root;
+        }
+
+        /**
+         * starts recording a node, the nodes recorded until it is closed are its descendants
+         */
+        std::uint32_t open( Node::EType type, const void* ast, std::uint32_t choice, std::size_t begin )
+        {
+            const std::uint32_t node = static_cast<std::uint32_t>( m_nodes.size() );
+            const std::uint32_t parent = m_current == s_root ? 0 : node - m_current;
+            const std::size_t parentBegin = m_begins.empty() ? 0 : m_begins.back();
+            m_nodes.push_back( Node{ type, ast, parent, 0, begin - parentBegin, 0, choice } );
+            m_begins.push_back( begin );
+            m_current = node;
+            return m_current;
+        }
+
+        void close( std::uint32_t node, std::size_t end )
+        {
+            m_nodes[node].length = end - m_begins.back();
+            m_nodes[node].size = static_cast<std::uint32_t>( m_nodes.size() - node );
+            m_begins.pop_back();
+            m_current = static_cast<std::uint32_t>( parent( node ) );
+        }
+
+        /**
+         * replaces the subtree of a node by a new derivation of the same ast node
+         * 
+         * @param node node replaced
+         * @param str string generated by the new derivation
+         * @param sub new derivation, its root replaces the node
+         */
+        void splice( std::size_t node, const std::string& str, const Derivation& sub )
+        {
+            const Node old = m_nodes[node];
+            const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>( str.size() ) - static_cast<std::ptrdiff_t>( old.length );
+            const std::ptrdiff_t count = static_cast<std::ptrdiff_t>( sub.m_nodes.size() ) - static_cast<std::ptrdiff_t>( old.size );
+
+            m_str.replace( begin( node ), old.length, str );
+
+            // the nodes of sub are relative to its root, which takes the place of the node
+            if( count > 0 )
+                m_nodes.insert( m_nodes.begin() + node, count, Node() );
+            else if( count < 0 )
+                m_nodes.erase( m_nodes.begin() + node, m_nodes.begin() + node - count );
+            std::copy( sub.m_nodes.begin(), sub.m_nodes.end(), m_nodes.begin() + node );
+            m_nodes[node].parent = old.parent;
+            m_nodes[node].begin = old.begin;
+
+            if( delta == 0 && count == 0 )
+                return;
+
+            // the ancestors contain the new subtree, the siblings following it and its ancestors are shifted
+            std::size_t child = node;
+            for( std::size_t p = parent( node ); p != s_root; child = p, p = parent( p ) )
+            {
+                m_nodes[p].length += delta;
+                m_nodes[p].size += count;
+                for( std::size_t next = end( child ); next < end( p ); next = end( next ) )
+                {
+                    m_nodes[next].begin += delta;
+                    m_nodes[next].parent += count;
+                }
+            }
+        }
+
+        std::string m_str;
+        std::vector<Node> m_nodes;
+
+        /** node being recorded */
+        std::uint32_t m_current = s_root;
+
+        /** absolute begin of the nodes being recorded, from the root to the current one */
+        std::vector<std::size_t> m_begins;
+    };
+}
\ No newline at end of file
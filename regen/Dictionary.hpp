@@ -0,0 +1,242 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include <boost/utility/string_view.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "Weighting.hpp"
+
+namespace regen
+{
+    /**
+     * List of words read from a file, referenced as {name} in a regex
+     * once registered on a Generator (@see Generator::addDictionary)
+     * 
+     * The file is read in memory, or mapped (@see mapDictionary), and indexed once: a word is picked
+     * in O(1) and appended to the generated string straight from the buffer.
+     * A dictionary is immutable, threads and copies of a generator share it through a shared_ptr.
+     * 
+     * - WORDS: one word per line, picked uniformly
+     * - WEIGHTED: one "word<TAB>weight" per line, picked proportionally to the weights
+     * 
+     * Empty lines are skipped and a trailing '\r' is removed.
+     */
+    class Dictionary
+    {
+    public:
+        enum EFormat
+        {
+            WORDS,
+            WEIGHTED
+        };
+
+        /**
+         * reads and indexes a dictionary file
+         * 
+         * @param path path of the file
+         * @param format format of the lines
+         * 
+         * @throw std::runtime_error the file cannot be read, has no word or a line is invalid
+         */
+        explicit Dictionary( const std::string& path, EFormat format = WORDS )
+        : m_path( path )
+        {
+            auto text = read( path );
+            m_data = text->data();
+            m_size = text->size();
+            m_owner = std::move( text );
+            index( format );
+        }
+
+        /**
+         * indexes the lines of a buffer held by the caller, e.g. a mapped file
+         * 
+         * @param path path of the file, for the error messages
+         * @param data content of the file, the words point into it
+         * @param owner keeps data alive as long as the dictionary
+         * @param format format of the lines
+         * 
+         * @throw std::runtime_error the buffer has no word or a line is invalid
+         */
+        Dictionary( const std::string& path, boost::string_view data, std::shared_ptr<const void> owner, EFormat format = WORDS )
+        : m_path( path ),
+        m_owner( std::move( owner ) ),
+        m_data( data.data() ),
+        m_size( data.size() )
+        {
+            index( format );
+        }
+
+        Dictionary( const Dictionary& ) = delete;
+        Dictionary& operator=( const Dictionary& ) = delete;
+
+        /** @return number of words */
+        std::size_t size() const { return m_words.size(); }
+
+        /** @return the i-th word, pointing into the mapping */
+        boost::string_view operator[]( std::size_t i ) const
+        {
+            return boost::string_view( m_data + m_words[i].offset, m_words[i].length );
+        }
+
+        /** @return index of a random word */
+        template<class Engine>
+        std::size_t pick( Engine& rng ) const
+        {
+            if( m_weights )
+                return (*m_weights)( rng );
+
+            boost::random::uniform_int_distribution<std::size_t> word_dice( 0, m_words.size()-1 );
+            return word_dice( rng );
+        }
+
+        const std::string& path() const { return m_path; }
+
+        /** @return length in bytes of the shortest word */
+        std::size_t minLength() const { return m_minLength; }
+
+        /** @return length in bytes of the longest word */
+        std::size_t maxLength() const { return m_maxLength; }
+
+        /** @return expected length in bytes of a picked word */
+        double expectedLength() const { return m_expectedLength; }
+
+        /** @return bits of entropy of a pick */
+        double entropy() const { return m_entropy; }
+
+    private:
+        /** a word is m_data[offset, offset + length) */
+        struct Word
+        {
+            std::uint64_t offset;
+            std::uint32_t length;
+        };
+
+        static std::shared_ptr<const std::string> read( const std::string& path )
+        {
+            std::ifstream in( path, std::ios::binary );
+            if( !in )
+                throw std::runtime_error( "cannot open dictionary '" + path + "': " + std::strerror( errno ) );
+
+            auto res = std::make_shared<const std::string>( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+            if( in.bad() || res->empty() )
+                throw std::runtime_error( "dictionary '" + path + "' is empty or cannot be read" );
+            return res;
+        }
+
+        void index( EFormat format )
+        {
+            std::vector<double> weights;
+            std::size_t lineNumber = 0;
+
+            for( std::size_t begin = 0; begin < m_size; )
+            {
+                const char* newline = static_cast<const char*>( std::memchr( m_data + begin, '\n', m_size - begin ) );
+                const std::size_t next = newline ? static_cast<std::size_t>( newline - m_data ) + 1 : m_size;
+                std::size_t end = newline ? next - 1 : m_size;
+                const std::size_t line = begin;
+                begin = next;
+                ++lineNumber;
+
+                if( end > line && m_data[end - 1] == '\r' )
+                    --end;
+                if( end == line )
+                    continue;
+
+                if( format == WEIGHTED )
+                {
+                    std::size_t tab = end;
+                    while( tab > line && m_data[tab - 1] != '\t' )
+                        --tab;
+
+                    const std::string weight( m_data + tab, m_data + end );
+                    char* parsed = nullptr;
+                    const double w = std::strtod( weight.c_str(), &parsed );
+                    if( tab <= line + 1 || weight.empty() || *parsed != '\0' || !std::isfinite( w ) || w < 0 )
+                        throw std::runtime_error( m_path + ":" + std::to_string( lineNumber ) + ": expected <word><TAB><weight>" );
+
+                    weights.push_back( w );
+                    end = tab - 1;
+                }
+
+                if( end - line > std::numeric_limits<std::uint32_t>::max() )
+                    throw std::runtime_error( m_path + ":" + std::to_string( lineNumber ) + ": word too long" );
+                m_words.push_back( Word{ line, static_cast<std::uint32_t>( end - line ) } );
+            }
+
+            if( m_words.empty() )
+                throw std::runtime_error( "dictionary '" + m_path + "' has no word" );
+
+            if( format == WEIGHTED )
+                m_weights = std::make_unique<AliasTable>( weights );
+
+            double total = 0;
+            for( double w : weights )
+                total += w;
+
+            m_minLength = std::numeric_limits<std::size_t>::max();
+            for( std::size_t i = 0; i < m_words.size(); ++i )
+            {
+                const double p = m_weights ? weights[i] / total : 1.0 / m_words.size();
+                m_minLength = std::min<std::size_t>( m_minLength, m_words[i].length );
+                m_maxLength = std::max<std::size_t>( m_maxLength, m_words[i].length );
+                m_expectedLength += p * m_words[i].length;
+                if( p > 0 )
+                    m_entropy -= p * std::log2( p );
+            }
+        }
+
+        std::string m_path;
+
+        /** content of the file, held by m_owner */
+        std::shared_ptr<const void> m_owner;
+        const char* m_data = nullptr;
+        std::size_t m_size = 0;
+
+        std::vector<Word> m_words;
+
+        /** WEIGHTED: picks the words, WORDS: null */
+        std::unique_ptr<AliasTable> m_weights;
+
+        std::size_t m_minLength = 0;
+        std::size_t m_maxLength = 0;
+        double m_expectedLength = 0;
+        double m_entropy = 0;
+    };
+}
\ No newline at end of file
@@ -26,13 +26,38 @@
 
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/seed_seq.hpp>
 
 #include <ctime>
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+#include "Weighting.hpp"
+#include "Dictionary.hpp"
+#include "Derivation.hpp"
+#include "ThreadPool.hpp"
+#include "Budget.hpp"
 
 namespace regen
 {
+    /**
+     * derives the seed of an independent substream, e.g. of a block of strings, from a seed
+     * and the index of the substream (splitmix64)
+     * 
+     * @return the seed of the substream
+     */
+    inline std::uint64_t substreamSeed( std::uint64_t seed, std::uint64_t index )
+    {
+        std::uint64_t z = seed + ( index + 1 ) * 0x9E3779B97F4A7C15ull;
+        z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+        z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+        return z ^ ( z >> 31 );
+    }
+
     /**
      * Generates a random string matching the given regular expression
      * 
@@ -41,6 +66,7 @@ namespace regen
      * - minimum number of repetitions for + and * (default to 0, + will always be at least 1)
      * - range of characters that can be generated
      *   given in regex notation e.g. "[a-zA-Z]"
+     * - dictionaries referenced as {name} in the regexes (@see addDictionary)
      * 
      * The generation takes in a Re object which is created using a parser.
      * @see regen::Parser
@@ -48,6 +74,12 @@ namespace regen
     class Generator
     {
     public:
+        /** receives the successive chunks of a streamed string */
+        typedef std::function<void( const char* data, std::size_t size )> Sink;
+
+        /** characters of the negated or restricted sets of an ast with a generator's settings, by node */
+        typedef std::unordered_map<const Set*, CharSet> ResolvedSets;
+
 
         /**
          * generates a random string matching the given regular expression
@@ -75,18 +107,17 @@ namespace regen
             
             {
                 auto tokens = lexer( m_fullSetRegex );
-                auto fullSet = Parser().parseStandAloneSet( tokens );
-                m_fullSet = generateChoices( fullSet );
-                std::sort( m_fullSet.begin(), m_fullSet.end() );
+                m_fullSet = Parser().parseStandAloneSet( tokens ).chars;
             }
 
             if( !restricted_range.empty() )
             {
                 auto tokens = lexer(restricted_range);
                 auto restrictedSet = Parser().parseStandAloneSet( tokens );
-                m_restrictedSet = generateChoices( restrictedSet );
-                std::sort( m_restrictedSet.begin(), m_restrictedSet.end() );
+                m_restrictedSet = resolve( restrictedSet );
             }
+
+            m_anySet = m_restrictedSet.empty() ? m_fullSet : m_fullSet.intersection( m_restrictedSet );
         }
 
         /**
@@ -94,183 +125,753 @@ namespace regen
          * 
          * @param re regular expression ast (@see regen::Parser to create it)
          * 
-         * @return the generated string
+         * @return the generated string (UTF-8 encoded)
          */
         std::string generate( const Re& re ) const
         {
-            boost::random::uniform_int_distribution<> union_dice(0,re.unionRes.size()-1);
+            std::string res;
+            generate( re, res );
+            return res;
+        }
 
-            return generate( re.unionRes[union_dice(m_rng)] );
+        /**
+         * appends a random string matching the given regular expression
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param out string the generated string is appended to (UTF-8 encoded)
+         */
+        void generate( const Re& re, std::string& out ) const
+        {
+            State state{ out, m_rng };
+            generate( re, state );
         }
 
-    private:
-        std::string generate( const SimpleRe& sre ) const
+        /**
+         * generates a random string matching the given regular expression,
+         * skewed by the given weights
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param weighting weights of the alternatives, repetitions and characters of re
+         *                  (@see regen::Weighting)
+         * 
+         * @return the generated string (UTF-8 encoded)
+         */
+        std::string generate( const Re& re, const Weighting& weighting ) const
         {
             std::string res;
+            State state{ res, m_rng };
+            state.weighting = &weighting;
+            generate( re, state );
+            return res;
+        }
 
-            for( const BasicRe& br : sre.concatRes )
+        /**
+         * appends a random string matching the given regular expression,
+         * aborting the generation if it exceeds a budget
+         * 
+         * The budget is checked as the ast is walked: the bytes once the last character
+         * is appended, the visits at each node and the deadline every 1024 nodes.
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param out string the generated string is appended to (UTF-8 encoded),
+         *            it is left with a partial string if the budget is exceeded
+         * @param budget limits of the generation
+         * 
+         * @throw BudgetExceeded the generation exceeded the budget
+         */
+        void generate( const Re& re, std::string& out, const Budget& budget ) const
+        {
+            State state{ out, m_rng };
+            state.budget = &budget;
+            state.base = out.size();
+            generate( re, state );
+            if( out.size() - state.base > budget.maxBytes )
+                throw BudgetExceeded( BudgetExceeded::BYTES, "the generated string exceeds the maximum size" );
+        }
+
+        /**
+         * generates a random string matching the given regular expression
+         * and records the choices made in a derivation
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param derivation cleared then filled with the derivation tree of the string
+         * 
+         * @return the generated string (UTF-8 encoded), also available as derivation.str()
+         */
+        const std::string& generate( const Re& re, Derivation& derivation ) const
+        {
+            derivation.clear();
+            State state{ derivation.m_str, m_rng };
+            state.derivation = &derivation;
+            generate( re, state );
+            return derivation.str();
+        }
+
+        /**
+         * regenerates a single node of a derivation, the rest of the string is kept as is
+         * 
+         * Only the subtree of the node is generated again, then its ancestors and their following
+         * siblings are updated. If the new subtree differs in length or number of nodes, the rest of
+         * the string and of the nodes is also moved in memory.
+         * The regex ast the derivation was generated from must still be alive.
+         * 
+         * @param derivation derivation generated by this generator
+         * @param node index of the node to regenerate in derivation.nodes()
+         * 
+         * @throw std::out_of_range the node does not exist
+         */
+        void mutate( Derivation& derivation, std::size_t node ) const
+        {
+            if( node >= derivation.size() )
+                throw std::out_of_range( "no such derivation node" );
+
+            const Derivation::Node& old = derivation[node];
+
+            std::string piece;
+            Derivation sub;
+            State state{ piece, m_rng };
+            state.derivation = &sub;
+
+            switch( old.type )
             {
-                res += generate( br );
+            case Derivation::Node::UNION:
+                generate( *static_cast<const Re*>( old.ast ), state );
+                break;
+            case Derivation::Node::REPETITION:
+                generate( *static_cast<const BasicReSub*>( old.ast ), state );
+                break;
+            case Derivation::Node::ELEMENT:
+                generate( *static_cast<const ElementaryRe*>( old.ast ), state );
+                break;
             }
 
+            derivation.splice( node, piece, sub );
+        }
+
+        /**
+         * generates a random string matching the given regular expression
+         * and writes it to a sink in chunks, without holding the whole string in memory
+         * 
+         * The string is the same as the one generate( re ) would return.
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param sink called with each chunk of the string (UTF-8 encoded)
+         * @param chunkSize size of the chunks in bytes, the last one may be smaller
+         *                  and a chunk may be a few bytes larger so that characters are not split
+         */
+        void generate( const Re& re, const Sink& sink, std::size_t chunkSize = 1 << 16 ) const
+        {
+            std::string buffer;
+            buffer.reserve( chunkSize + 4 );
+            State state{ buffer, m_rng };
+            state.sink = &sink;
+            state.chunkSize = std::max<std::size_t>( chunkSize, 1 );
+            generate( re, state );
+            if( !buffer.empty() )
+                sink( buffer.data(), buffer.size() );
+        }
+
+        /**
+         * generates a random string matching the given regular expression,
+         * the large repetitions being split in chunks generated by a pool of threads
+         * 
+         * Each chunk has its own random number generator seeded from a single draw and the
+         * index of the chunk, so the string does not depend on the number of threads.
+         * It differs from the one generate( re ) would return with the same seed though.
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param pool threads generating the chunks
+         * @param chunkIterations number of iterations of a chunk, repetitions of at least
+         *                        twice this number are split
+         * 
+         * @return the generated string (UTF-8 encoded)
+         */
+        std::string generate( const Re& re, ThreadPool& pool, std::size_t chunkIterations = 1 << 16 ) const
+        {
+            std::string res;
+            State state{ res, m_rng };
+            state.pool = &pool;
+            state.chunkIterations = std::max<std::size_t>( chunkIterations, 1 );
+            generate( re, state );
             return res;
         }
 
-        std::string generate( const BasicRe& bre ) const
+        /**
+         * seeds the random number generator, two generators with the same settings
+         * and the same seed generate the same strings
+         * 
+         * @param seed seed of the random number generator
+         */
+        void seed( std::uint64_t seed )
+        {
+            boost::random::seed_seq seq{ static_cast<std::uint32_t>( seed ), static_cast<std::uint32_t>( seed >> 32 ) };
+            m_rng.seed( seq );
+        }
+
+        /**
+         * computes the characters a set can generate with this generator's settings,
+         * i.e. with negation and the restricted range applied
+         * 
+         * @param se set from the regex ast
+         * 
+         * @return the characters the set can generate
+         */
+        CharSet resolve( const Set& se ) const
+        {
+            CharSet choices = se.negative ? m_fullSet.difference( se.chars ) : se.chars;
+
+            if( !m_restrictedSet.empty() )
+                choices = choices.intersection( m_restrictedSet );
+
+            return choices;
+        }
+
+        /**
+         * resolves once the sets of an ast which differ from their characters with this generator's settings,
+         * i.e. the negated sets or all of them with a restricted range
+         * 
+         * @param re regular expression ast
+         * @param sets filled with the characters of each such set
+         */
+        void resolve( const Re& re, ResolvedSets& sets ) const
+        {
+            if( re.literals )
+                return;
+
+            for( const SimpleRe& sre : re.unionRes() )
+            {
+                for( const BasicRe& bre : sre.concatRes )
+                {
+                    const ElementaryRe* ere = dynamic_cast<const ElementaryRe*>( bre.sub.get() );
+                    if( !ere )
+                        ere = quantified( *bre.sub );
+
+                    if( auto ptr = dynamic_cast<const Group*>( ere ) )
+                        resolve( ptr->re, sets );
+                    else if( auto ptr = dynamic_cast<const Set*>( ere ) )
+                    {
+                        if( ( ptr->negative || !m_restrictedSet.empty() ) && !sets.count( ptr ) )
+                            sets.emplace( ptr, resolve( *ptr ) );
+                    }
+                }
+            }
+        }
+
+        /**
+         * @return the characters '.' can generate with this generator's settings
+         */
+        const CharSet& resolve( const Any& ) const
+        {
+            return m_anySet;
+        }
+
+        /**
+         * @param quantifier *, +, ? or {n,m} node of the regex ast
+         * 
+         * @throw std::runtime_error the node is not a quantifier
+         * 
+         * @return min and max number of repetitions of a quantifier with this generator's settings
+         */
+        std::pair<std::size_t, std::size_t> repetitionBounds( const BasicReSub& quantifier ) const
+        {
+            if( dynamic_cast<const Star*>( &quantifier ) )
+                return { m_repetition_min, m_repetition_max };
+            if( dynamic_cast<const Plus*>( &quantifier ) )
+                return { std::max<std::size_t>( m_repetition_min, 1 ), m_repetition_max };
+            if( dynamic_cast<const Question*>( &quantifier ) )
+                return { 0, 1 };
+            if( auto ptr = dynamic_cast<const NumericRange*>( &quantifier ) )
+                return { ptr->min, ptr->max };
+
+            throw std::runtime_error( "expected a quantified regex (*, +, ? or {n,m})" );
+        }
+
+        /**
+         * registers a dictionary, referenced as {name} in the regexes this generator generates
+         * copies of the generator share the dictionary
+         * 
+         * @param name name of the dictionary in the regexes, replaces a dictionary of the same name
+         * @param dictionary the words
+         */
+        void addDictionary( const std::string& name, std::shared_ptr<const Dictionary> dictionary )
+        {
+            if( !dictionary )
+                throw std::logic_error( "null dictionary" );
+            m_dictionaries[name] = std::move( dictionary );
+        }
+
+        /**
+         * @throw std::runtime_error no dictionary is registered with that name
+         * 
+         * @return the dictionary registered with that name
+         */
+        const Dictionary& dictionary( const std::string& name ) const
+        {
+            auto it = m_dictionaries.find( name );
+            if( it == m_dictionaries.end() )
+                throw std::runtime_error( "unknown dictionary {" + name + "}" );
+            return *it->second;
+        }
+
+    private:
+        /** state of a single generation */
+        struct State
+        {
+            /** generated string */
+            std::string& out;
+
+            /** random number generator of the generation, the generator's or a chunk's (@see generateParallel) */
+            boost::random::mt19937& rng;
+
+            /** optional region of fixed size the string is written to instead of out (@see generateParallel) */
+            char* region = nullptr;
+
+            /** optional weights */
+            const Weighting* weighting = nullptr;
+
+            /** optional record of the choices */
+            Derivation* derivation = nullptr;
+
+            /** optional sink the string is flushed to once it reaches chunkSize bytes */
+            const Sink* sink = nullptr;
+            std::size_t chunkSize = 0;
+
+            /** optional pool the large repetitions are split on, in chunks of chunkIterations */
+            ThreadPool* pool = nullptr;
+            std::size_t chunkIterations = 0;
+
+            /** optional limits, the bytes are counted from base */
+            const Budget* budget = nullptr;
+            std::size_t base = 0;
+            std::size_t visits = 0;
+
+            /** optional sets resolved beforehand, the others are resolved on their first pick */
+            const ResolvedSets* resolved = nullptr;
+            ResolvedSets resolving{};
+        };
+
+        void generate( const Re& re, State& state ) const
+        {
+            if( state.budget )
+                spend( state );
+
+            std::size_t alternative;
+            const AliasTable* table = state.weighting ? state.weighting->alternatives( re ) : nullptr;
+            if( table )
+            {
+                alternative = (*table)(state.rng);
+            }
+            else
+            {
+                boost::random::uniform_int_distribution<> union_dice(0,re.size()-1);
+                alternative = union_dice(state.rng);
+            }
+
+            if( !state.derivation )
+                return generateAlternative( re, alternative, state );
+
+            const auto node = state.derivation->open( Derivation::Node::UNION, &re, alternative, state.out.size() );
+            generateAlternative( re, alternative, state );
+            state.derivation->close( node, state.out.size() );
+        }
+
+        void generateAlternative( const Re& re, std::size_t alternative, State& state ) const
+        {
+            if( re.literals )
+            {
+                const boost::string_view literal = (*re.literals)[alternative];
+                write( literal.data(), literal.size(), state );
+            }
+            else
+            {
+                generate( re.unionRes()[alternative], state );
+            }
+        }
+
+        void generate( const SimpleRe& sre, State& state ) const
+        {
+            for( const BasicRe& br : sre.concatRes )
+            {
+                generate( br, state );
+            }
+        }
+
+        void generate( const BasicRe& bre, State& state ) const
+        {
+            generate( *bre.sub, state );
+        }
+
+        void generate( const BasicReSub& sub, State& state ) const
         {
-            if( auto ptr = dynamic_cast<const Star*>( bre.sub.get() ) )
-                return generate( *ptr );
-            if( auto ptr = dynamic_cast<const Plus*>( bre.sub.get() ) )
-                return generate( *ptr );
-            if( auto ptr = dynamic_cast<const Question*>( bre.sub.get() ) )
-                return generate( *ptr );
-            if( auto ptr = dynamic_cast<const NumericRange*>( bre.sub.get() ) )
-                return generate( *ptr );
-            if( auto ptr = dynamic_cast<const ElementaryRe*>( bre.sub.get() ) )
-                return generate( *ptr );
+            if( auto ptr = dynamic_cast<const Star*>( &sub ) )
+                return generate( *ptr, state );
+            if( auto ptr = dynamic_cast<const Plus*>( &sub ) )
+                return generate( *ptr, state );
+            if( auto ptr = dynamic_cast<const Question*>( &sub ) )
+                return generate( *ptr, state );
+            if( auto ptr = dynamic_cast<const NumericRange*>( &sub ) )
+                return generate( *ptr, state );
+            if( auto ptr = dynamic_cast<const ElementaryRe*>( &sub ) )
+                return generate( *ptr, state );
 
             throw std::logic_error( "unknown basic-re type" );
         }
 
-        std::string generate( const ElementaryRe& ere ) const
+        void generate( const ElementaryRe& ere, State& state ) const
+        {
+            if( state.budget )
+                spend( state );
+
+            if( state.derivation )
+            {
+                const auto node = state.derivation->open( Derivation::Node::ELEMENT, &ere, 0, state.out.size() );
+                generateElement( ere, state );
+                state.derivation->close( node, state.out.size() );
+            }
+            else
+            {
+                generateElement( ere, state );
+            }
+
+            if( state.sink && state.out.size() >= state.chunkSize )
+            {
+                (*state.sink)( state.out.data(), state.out.size() );
+                state.out.clear();
+            }
+        }
+
+        void generateElement( const ElementaryRe& ere, State& state ) const
         {
             if( auto ptr = dynamic_cast<const Group*>( &ere ) )
-                return generate( *ptr );
+                return generate( *ptr, state );
             if( auto ptr = dynamic_cast<const Any*>( &ere ) )
-                return generate( *ptr );
+                return generate( *ptr, state );
             if( auto ptr = dynamic_cast<const Char*>( &ere ) )
-                return generate( *ptr );
+                return generate( *ptr, state );
             if( auto ptr = dynamic_cast<const Set*>( &ere ) )
-                return generate( *ptr );
+                return generate( *ptr, state );
+            if( auto ptr = dynamic_cast<const Reference*>( &ere ) )
+                return generate( *ptr, state );
 
             throw std::logic_error( "unknown elementary-re type" );
         }
 
-        std::string generate( const Star& star ) const
+        void generate( const Star& star, State& state ) const
         {
-            return generateRepetition( *star.re, m_repetition_min, m_repetition_max );
+            generateRepetition( star, *star.re, m_repetition_min, m_repetition_max, state );
         }
 
-        std::string generate( const Plus& plus ) const
+        void generate( const Plus& plus, State& state ) const
         {
             const auto rep_min = std::max<std::size_t>( m_repetition_min, 1 );
-            return generateRepetition( *plus.re, rep_min, m_repetition_max );
+            generateRepetition( plus, *plus.re, rep_min, m_repetition_max, state );
         }
 
-        std::string generate( const Question& question ) const
+        void generate( const Question& question, State& state ) const
         {
-            return generateRepetition( *question.re, 0, 1 );
+            generateRepetition( question, *question.re, 0, 1, state );
         }
 
-        std::string generate( const NumericRange& nrange ) const
+        void generate( const NumericRange& nrange, State& state ) const
         {
-            return generateRepetition( *nrange.re, nrange.min, nrange.max );
+            generateRepetition( nrange, *nrange.re, nrange.min, nrange.max, state );
         }
 
-        std::string generateRepetition( const ElementaryRe& ere, int min, int max ) const
+        void generateRepetition( const BasicReSub& quantifier, const ElementaryRe& ere, int min, int max, State& state ) const
         {
-            std::string res = "";
-            boost::random::uniform_int_distribution<> iter_dice(min,max);
+            std::size_t iterations;
+            const Weighting::RepetitionTable* table = state.weighting ? state.weighting->repetitions( quantifier ) : nullptr;
+            if( table )
+            {
+                iterations = table->min + table->table(state.rng);
+            }
+            else
+            {
+                boost::random::uniform_int_distribution<> iter_dice(min,max);
+                iterations = iter_dice(state.rng);
+            }
 
-            std::size_t iterations = iter_dice(m_rng);
-            for( std::size_t i = 0; i < iterations; ++i )
-                res += generate( ere );
+            if( state.budget )
+                spend( state );
 
-            return res;
-        }
+            if( state.pool && iterations >= 2 * state.chunkIterations )
+                return generateParallel( ere, iterations, state );
 
-        std::string generate( const Group& gr ) const
-        {
-            return generate( gr.re );
-        }
+            if( !state.derivation )
+            {
+                for( std::size_t i = 0; i < iterations; ++i )
+                    generate( ere, state );
+                return;
+            }
 
-        std::string generate( const Any& any ) const
-        {
-            auto tokens = lexer( m_fullSetRegex );
-            auto fullSet = Parser().parseStandAloneSet( tokens );
-            return generate( fullSet );
+            const auto node = state.derivation->open( Derivation::Node::REPETITION, &quantifier, iterations, state.out.size() );
+            for( std::size_t i = 0; i < iterations; ++i )
+                generate( ere, state );
+            state.derivation->close( node, state.out.size() );
         }
 
-        std::string generate( const Char& c ) const
+        /**
+         * counts a visit against the budget of the state
+         * 
+         * @throw BudgetExceeded the budget is exceeded
+         */
+        void spend( State& state ) const
         {
-            return std::string( 1, c.c );
+            const Budget& budget = *state.budget;
+
+            if( ++state.visits > budget.maxVisits )
+                throw BudgetExceeded( BudgetExceeded::VISITS, "the generation exceeds the maximum number of visited nodes" );
+            if( state.out.size() - state.base > budget.maxBytes )
+                throw BudgetExceeded( BudgetExceeded::BYTES, "the generated string exceeds the maximum size" );
+            if( ( state.visits & 0x3FF ) == 0 && budget.deadline != std::chrono::steady_clock::time_point::max()
+                && std::chrono::steady_clock::now() > budget.deadline )
+                throw BudgetExceeded( BudgetExceeded::TIME, "the generation exceeds its deadline" );
         }
 
-        std::string generate( const Set& se ) const
+        /**
+         * generates the iterations of a repetition in chunks on the pool of the state
+         */
+        void generateParallel( const ElementaryRe& ere, std::size_t iterations, State& state ) const
         {
-            // generates a list of choices and pick one
-            std::string choices = generateChoices( se );
+            const std::uint32_t seed[2] = { state.rng(), state.rng() };
+            const std::size_t chunks = ( iterations + state.chunkIterations - 1 ) / state.chunkIterations;
+            const std::size_t length = state.weighting ? s_variableLength : fixedLength( ere );
+            const std::size_t begin = state.out.size();
+
+            // fixed length: each chunk is written straight to its own region of the output,
+            // otherwise the chunks are kept until they are all generated
+            std::vector<std::string> pieces( length == s_variableLength ? chunks : 0 );
+            if( length != s_variableLength )
+                state.out.resize( begin + iterations * length );
+
+            std::vector<std::future<void>> futures;
+            futures.reserve( chunks );
+            for( std::size_t c = 0; c < chunks; ++c )
+            {
+                futures.push_back( state.pool->submit( [&, c]
+                {
+                    // the chunks only differ by their random number generator
+                    boost::random::seed_seq seq{ seed[0], seed[1], static_cast<std::uint32_t>( c ), static_cast<std::uint32_t>( std::uint64_t( c ) >> 32 ) };
+                    boost::random::mt19937 rng( seq );
+
+                    const std::size_t first = c * state.chunkIterations;
+                    const std::size_t count = std::min( state.chunkIterations, iterations - first );
+
+                    std::string piece;
+                    State chunkState{ piece, rng };
+                    chunkState.weighting = state.weighting;
+                    chunkState.resolved = state.resolved;
+                    if( length != s_variableLength )
+                        chunkState.region = &state.out[begin + first * length];
+                    for( std::size_t i = 0; i < count; ++i )
+                        generate( ere, chunkState );
+
+                    if( length == s_variableLength )
+                        pieces[c] = std::move( piece );
+                } ) );
+            }
 
-            boost::random::uniform_int_distribution<> choice_dice(0,choices.size()-1);
+            // wait for all the chunks before rethrowing, the tasks refer to this frame
+            for( std::future<void>& future : futures )
+                future.wait();
+            for( std::future<void>& future : futures )
+                future.get();
 
-            return std::string( 1, choices[choice_dice(m_rng)] );
+            if( length == s_variableLength )
+            {
+                std::size_t size = 0;
+                for( const std::string& piece : pieces )
+                    size += piece.size();
+                state.out.reserve( begin + size );
+                for( const std::string& piece : pieces )
+                    state.out += piece;
+            }
         }
 
-        std::string generateChoices( const Set& se ) const
+        enum : std::size_t
         {
-            std::string choices = "";
+            s_variableLength = static_cast<std::size_t>( -1 )
+        };
 
-            for( const std::unique_ptr<SetItem>& item : se.items )
-            {
-                choices += generate( *item );
-            }
+        /**
+         * @return the length in bytes of every string an elementary regex generates,
+         *         s_variableLength if they do not all have the same length
+         */
+        std::size_t fixedLength( const ElementaryRe& ere ) const
+        {
+            if( auto ptr = dynamic_cast<const Char*>( &ere ) )
+                return utf8Length( ptr->c );
 
-            if( se.negative )
+            if( auto ptr = dynamic_cast<const Group*>( &ere ) )
             {
-                std::string restrictedChoices;
-                restrictedChoices.resize(m_fullSet.size());
-                std::sort( choices.begin(), choices.end() );
-                auto it = std::set_difference( m_fullSet.begin(), m_fullSet.end(),
-                                                choices.begin(), choices.end(),
-                                                restrictedChoices.begin() );
-                restrictedChoices.resize(it-restrictedChoices.begin());
-                choices = restrictedChoices;
+                if( const auto& literals = ptr->re.literals )
+                {
+                    for( std::size_t i = 1; i < literals->size(); ++i )
+                        if( (*literals)[i].size() != (*literals)[0].size() )
+                            return s_variableLength;
+                    return (*literals)[0].size();
+                }
+
+                std::size_t res = s_variableLength;
+                for( const SimpleRe& sre : ptr->re.unionRes() )
+                {
+                    std::size_t length = 0;
+                    for( const BasicRe& bre : sre.concatRes )
+                    {
+                        std::size_t count = 1;
+                        const ElementaryRe* sub = dynamic_cast<const ElementaryRe*>( bre.sub.get() );
+                        if( !sub )
+                        {
+                            const auto bounds = repetitionBounds( *bre.sub );
+                            if( bounds.first != bounds.second )
+                                return s_variableLength;
+                            count = bounds.first;
+                            sub = quantified( *bre.sub );
+                        }
+                        const std::size_t subLength = fixedLength( *sub );
+                        if( subLength == s_variableLength )
+                            return s_variableLength;
+                        length += count * subLength;
+                    }
+                    if( res != s_variableLength && res != length )
+                        return s_variableLength;
+                    res = length;
+                }
+                return res;
             }
 
-            if( !m_restrictedSet.empty() )
+            if( auto ptr = dynamic_cast<const Reference*>( &ere ) )
             {
-                std::string restrictedChoices;
-                restrictedChoices.resize(m_restrictedSet.size());
-                std::sort( choices.begin(), choices.end() );
-                auto it = std::set_intersection( m_restrictedSet.begin(), m_restrictedSet.end(),
-                                                choices.begin(), choices.end(),
-                                                restrictedChoices.begin() );
-                restrictedChoices.resize(it-restrictedChoices.begin());
-                choices = restrictedChoices;
+                const Dictionary& dictionary = this->dictionary( ptr->name );
+                return dictionary.minLength() == dictionary.maxLength() ? dictionary.minLength() : s_variableLength;
             }
 
-            return choices;
+            CharSet choices;
+            if( auto ptr = dynamic_cast<const Set*>( &ere ) )
+                choices = resolve( *ptr );
+            else
+                choices = m_anySet;
+            if( choices.empty() )
+                return s_variableLength;
+            const std::size_t length = utf8Length( choices.intervals().front().first );
+            return length == utf8Length( choices.intervals().back().last ) ? length : s_variableLength;
         }
 
-        std::string generate( const SetItem& si ) const
+        void generate( const Group& gr, State& state ) const
         {
-            if( auto ptr = dynamic_cast<const CharItem*>( &si ) )
-                return generate( *ptr );
-            if( auto ptr = dynamic_cast<const Range*>( &si ) )
-                return generate( *ptr );
+            generate( gr.re, state );
+        }
 
-            throw std::logic_error( "unknown elementary-re type" );
+        void generate( const Any&, State& state ) const
+        {
+            pick( m_anySet, state );
         }
 
-        std::string generate( const CharItem& c ) const
+        void generate( const Char& c, State& state ) const
         {
-            return std::string( 1, c.c );
+            write( c.c, state );
         }
 
-        std::string generate( const Range& r ) const
+        void generate( const Set& se, State& state ) const
         {
-            std::string res = "";
+            if( state.weighting )
+            {
+                if( auto table = state.weighting->characters( se ) )
+                {
+                    const std::size_t i = table->table(state.rng);
+                    if( i < table->chars.size() )
+                        append( table->chars[i], state );
+                    else
+                        pick( table->others, state );
+                    return;
+                }
+            }
 
-            for( char c = r.start; c <= r.end; ++c )
+            if( !se.negative && m_restrictedSet.empty() )
+                pick( se.chars, state );
+            else
+                pick( resolved( se, state ), state );
+        }
+
+        /**
+         * @return the characters of a negated or restricted set, resolved once per generation at most
+         */
+        const CharSet& resolved( const Set& se, State& state ) const
+        {
+            if( state.resolved )
             {
-                res += c;
+                auto it = state.resolved->find( &se );
+                if( it != state.resolved->end() )
+                    return it->second;
             }
 
-            return res;
+            auto it = state.resolving.find( &se );
+            if( it == state.resolving.end() )
+                it = state.resolving.emplace( &se, resolve( se ) ).first;
+            return it->second;
+        }
+
+        void generate( const Reference& ref, State& state ) const
+        {
+            const Dictionary& dictionary = this->dictionary( ref.name );
+            const std::size_t i = dictionary.pick( state.rng );
+            const boost::string_view word = dictionary[i];
+            write( word.data(), word.size(), state );
+            if( state.derivation )
+                state.derivation->m_nodes[state.derivation->m_current].choice = static_cast<std::uint32_t>( i );
+        }
+
+        /**
+         * appends a character picked uniformly in the given set
+         */
+        void pick( const CharSet& choices, State& state ) const
+        {
+            if( choices.empty() )
+                throw std::runtime_error( "no character can be generated from an empty set" );
+
+            boost::random::uniform_int_distribution<std::size_t> choice_dice(0,choices.size()-1);
+
+            append( choices[choice_dice(state.rng)], state );
+        }
+
+        /**
+         * appends a picked character, recorded as the choice of the current derivation node
+         */
+        void append( char32_t c, State& state ) const
+        {
+            write( c, state );
+            if( state.derivation )
+                state.derivation->m_nodes[state.derivation->m_current].choice = c;
+        }
+
+        /**
+         * appends bytes to the string, or to the region of the state
+         */
+        static void write( const char* data, std::size_t size, State& state )
+        {
+            if( state.region )
+                state.region = std::copy( data, data + size, state.region );
+            else
+                state.out.append( data, size );
+        }
+
+        /**
+         * appends a character to the string, or to the region of the state
+         */
+        static void write( char32_t c, State& state )
+        {
+            if( state.region )
+                state.region += writeUtf8( c, state.region );
+            else
+                appendUtf8( state.out, c );
         }
 
 
     private:
+        /** the specialized generation of a pattern uses the same random number generator, samplers are seeded from it */
+        friend class Pattern;
+        friend class LanguageSampler;
+
         /** random number generator */
         mutable boost::random::mt19937 m_rng;
 
@@ -284,7 +885,7 @@ namespace regen
          * this set is used with [^...] the negative set items are substracted from this one
          * the purpose is to avoid always generating junk out of this construct
          */
-        std::string m_fullSet;
+        CharSet m_fullSet;
 
         /** string used to generate m_fullSet */
         const std::string m_fullSetRegex;
@@ -293,6 +894,53 @@ namespace regen
          * this set is used to restric the pool of characters to pick from, as the user might not 
          * want to generate too "garbage" looking strings
          */
-        std::string m_restrictedSet;
+        CharSet m_restrictedSet;
+
+        /** characters generated by '.', i.e. m_fullSet within the restricted range */
+        CharSet m_anySet;
+
+        /** dictionaries referenced as {name} */
+        std::map<std::string, std::shared_ptr<const Dictionary>> m_dictionaries;
     };
-}
+
+    // Weighting members depending on the complete Generator type
+
+    inline Weighting::Weighting( const Generator& generator )
+    : m_generator( std::make_shared<Generator>( generator ) )
+    {
+    }
+
+    inline void Weighting::repetitions( const BasicRe& bre, const Distribution& distribution )
+    {
+        auto bounds = m_generator->repetitionBounds( *bre.sub );
+
+        m_repetitions.erase( bre.sub.get() );
+        m_repetitions.emplace( bre.sub.get(), RepetitionTable{ bounds.first, AliasTable( distribution.weights( bounds.first, bounds.second ) ) } );
+    }
+
+    inline void Weighting::characters( const Set& se, const std::map<char32_t, double>& frequencies, double others )
+    {
+        CharSet choices = m_generator->resolve( se );
+
+        std::vector<char32_t> chars;
+        std::vector<double> weights;
+        CharSet listed;
+        for( const auto& f : frequencies )
+        {
+            if( !choices.contains( f.first ) )
+                continue;
+            chars.push_back( f.first );
+            weights.push_back( f.second );
+            listed.insert( f.first, f.first );
+        }
+
+        CharSet rest = choices.difference( listed );
+        if( others > 0 && !rest.empty() )
+            weights.push_back( others * rest.size() );
+        else
+            rest = CharSet();
+
+        m_characters.erase( &se );
+        m_characters.emplace( &se, CharacterTable{ std::move( chars ), std::move( rest ), AliasTable( weights ) } );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,321 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Pattern.hpp"
+#include "ThreadPool.hpp"
+
+namespace regen
+{
+    /**
+     * Generates samples for many patterns at once on a pool of threads
+     * 
+     * Each job is a pattern and a number of samples. Jobs are split in chunks whose number
+     * of samples depends on the estimated cost of the pattern (@see Analysis::Stats::cost).
+     * Each job runs on up to all the threads of the work-stealing pool. A thread takes
+     * several chunks at once, and takes more as the measured time per sample shows that
+     * the job is cheap. Cheap patterns are then not scheduled chunk by chunk, and expensive
+     * ones do not hold a thread for long.
+     * 
+     * Each chunk is seeded from the seed of the jobs, the index of the job and the index of
+     * the chunk: the samples of a job do not depend on the number of threads nor on the timings.
+     * 
+     * @code
+     * regen::ThreadPool pool;
+     * regen::Jobs jobs( 42 );
+     * auto small = jobs.add( regen::Pattern( "a{12}" ), 100000 );
+     * auto large = jobs.add( regen::Pattern( "([A-Z][a-z]+ )([a-z]+ )+[A-Z][a-z]+\\." ), 100000 );
+     * jobs.run( pool );
+     * const std::vector<std::string>& samples = jobs.samples( large );
+     * @endcode
+     */
+    class Jobs
+    {
+    public:
+        struct Progress
+        {
+            /** number of samples requested */
+            std::size_t samples;
+
+            /** number of samples generated so far */
+            std::size_t generated;
+
+            /** size of the samples generated so far, in bytes */
+            std::uint64_t bytes;
+
+            /** seconds since the jobs started, until they were all done */
+            double seconds;
+
+            double samplesPerSecond;
+            double bytesPerSecond;
+
+            bool done;
+        };
+
+        /**
+         * @param seed seed of the samples
+         */
+        explicit Jobs( std::uint64_t seed = 0 )
+        : m_seed( seed ),
+        m_running( false )
+        {
+        }
+
+        /**
+         * adds a job, before the jobs are run
+         * 
+         * @param pattern pattern the samples are generated from
+         * @param count number of samples
+         * 
+         * @throw std::logic_error the jobs are already running
+         * 
+         * @return index of the job
+         */
+        std::size_t add( const Pattern& pattern, std::size_t count )
+        {
+            if( m_running )
+                throw std::logic_error( "jobs cannot be added once they run" );
+
+            // samples of a chunk, so that each chunk costs about s_chunkCost
+            const double cost = std::max( pattern.analysis().stats().cost, 1.0 );
+            const double chunk = std::min<double>( std::max( s_chunkCost / cost, 1.0 ), std::max<std::size_t>( count, 1 ) );
+
+            m_jobs.emplace_back( new Job( pattern, count, static_cast<std::size_t>( chunk ) ) );
+            return m_jobs.size() - 1;
+        }
+
+        /**
+         * runs the jobs and waits until they are done, progress() can be called meanwhile
+         * from other threads
+         * 
+         * @param pool threads running the jobs
+         * 
+         * @throw std::runtime_error a sample could not be generated
+         */
+        void run( ThreadPool& pool )
+        {
+            if( m_running )
+                throw std::logic_error( "jobs can only be run once" );
+
+            m_start = Clock::now();
+            m_running = true;
+
+            std::vector<std::future<void>> futures;
+            for( std::size_t j = 0; j < m_jobs.size(); ++j )
+            {
+                Job& job = *m_jobs[j];
+                if( job.count == 0 )
+                    job.finish( m_start );
+
+                const std::size_t runners = std::min( pool.size(), job.chunks );
+                for( std::size_t r = 0; r < runners; ++r )
+                    futures.push_back( pool.submit( [this, &job, j, runners]{ run( job, j, runners ); } ) );
+            }
+
+            for( std::future<void>& future : futures )
+                future.wait();
+            for( std::future<void>& future : futures )
+                future.get();
+        }
+
+        /** @return number of jobs */
+        std::size_t size() const { return m_jobs.size(); }
+
+        /**
+         * @return the samples of a job, in a deterministic order, once the jobs have run
+         */
+        const std::vector<std::string>& samples( std::size_t job ) const
+        {
+            return m_jobs.at( job )->samples;
+        }
+
+        /** @return progress of a job */
+        Progress progress( std::size_t job ) const
+        {
+            const Job& j = *m_jobs.at( job );
+            return progress( j.count, j.generated.load(), j.bytes.load(), j.done.load() ? j.end.load() : elapsed() );
+        }
+
+        /** @return progress of all the jobs */
+        Progress progress() const
+        {
+            std::size_t samples = 0;
+            std::size_t generated = 0;
+            std::uint64_t bytes = 0;
+            Clock::rep end = 0;
+            bool done = true;
+            for( const auto& job : m_jobs )
+            {
+                samples += job->count;
+                generated += job->generated.load();
+                bytes += job->bytes.load();
+                done = done && job->done.load();
+                end = std::max( end, job->end.load() );
+            }
+            return progress( samples, generated, bytes, done ? end : elapsed() );
+        }
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        /** estimated cost of a chunk, @see Analysis::Stats::cost */
+        static constexpr double s_chunkCost = 1 << 16;
+
+        enum : std::int64_t
+        {
+            /** time a thread generates a job before it takes chunks again */
+            s_claimMicroseconds = 5000
+        };
+
+        struct Job
+        {
+            Job( const Pattern& pattern, std::size_t count, std::size_t chunk )
+            : pattern( pattern ),
+            count( count ),
+            chunk( chunk ),
+            chunks( ( count + chunk - 1 ) / chunk ),
+            samples( count ),
+            next( 0 ),
+            generated( 0 ),
+            bytes( 0 ),
+            busy( 0 ),
+            end( 0 ),
+            done( false )
+            {
+            }
+
+            void finish( Clock::time_point start )
+            {
+                end = ( Clock::now() - start ).count();
+                done = true;
+            }
+
+            const Pattern pattern;
+            const std::size_t count;
+
+            /** number of samples of a chunk, and of chunks */
+            const std::size_t chunk;
+            const std::size_t chunks;
+
+            std::vector<std::string> samples;
+
+            /** first chunk no thread has taken yet */
+            std::atomic<std::size_t> next;
+
+            std::atomic<std::size_t> generated;
+            std::atomic<std::uint64_t> bytes;
+
+            /** time spent generating the samples so far, summed over the threads */
+            std::atomic<Clock::rep> busy;
+
+            /** time the job was done, since the start */
+            std::atomic<Clock::rep> end;
+            std::atomic<bool> done;
+        };
+
+        /**
+         * generates chunks of a job until all of them are taken
+         * 
+         * @param runners number of threads running the job
+         */
+        void run( Job& job, std::size_t index, std::size_t runners )
+        {
+            for( ;; )
+            {
+                const std::size_t take = claim( job, runners );
+                const std::size_t first = job.next.fetch_add( take );
+                if( first >= job.chunks )
+                    return;
+
+                for( std::size_t c = first; c < std::min( first + take, job.chunks ); ++c )
+                    generate( job, c * job.chunk, substreamSeed( substreamSeed( m_seed, index ), c ) );
+            }
+        }
+
+        /**
+         * @return number of chunks a thread takes at once: about s_claimMicroseconds of work
+         *         at the measured time per sample, at least one chunk and at most a share of the remaining ones
+         */
+        static std::size_t claim( const Job& job, std::size_t runners )
+        {
+            const std::size_t generated = job.generated.load();
+            const Clock::rep busy = job.busy.load();
+            const std::size_t next = job.next.load();
+            if( generated == 0 || busy <= 0 || next >= job.chunks )
+                return 1;
+
+            const double chunkTime = static_cast<double>( busy ) / generated * job.chunk;
+            const double chunks = std::chrono::duration_cast<Clock::duration>( std::chrono::microseconds( s_claimMicroseconds ) ).count() / chunkTime;
+            const std::size_t share = std::max<std::size_t>( ( job.chunks - next ) / ( 2 * runners ), 1 );
+            return static_cast<std::size_t>( std::max( 1.0, std::min( chunks, static_cast<double>( share ) ) ) );
+        }
+
+        void generate( Job& job, std::size_t first, std::uint64_t seed )
+        {
+            const Clock::time_point start = Clock::now();
+            Pattern pattern( job.pattern );
+            pattern.seed( seed );
+
+            const std::size_t last = std::min( job.count, first + job.chunk );
+            std::uint64_t bytes = 0;
+            for( std::size_t i = first; i < last; ++i )
+            {
+                job.samples[i] = pattern.generate();
+                bytes += job.samples[i].size();
+            }
+
+            job.bytes += bytes;
+            job.busy += ( Clock::now() - start ).count();
+            if( job.generated.fetch_add( last - first ) + ( last - first ) == job.count )
+                job.finish( m_start );
+        }
+
+        Clock::rep elapsed() const
+        {
+            return m_running ? ( Clock::now() - m_start ).count() : 0;
+        }
+
+        static Progress progress( std::size_t samples, std::size_t generated, std::uint64_t bytes, Clock::rep duration )
+        {
+            const double seconds = std::chrono::duration<double>( Clock::duration( duration ) ).count();
+            return Progress{ samples, generated, bytes, seconds,
+                             seconds > 0 ? generated / seconds : 0,
+                             seconds > 0 ? bytes / seconds : 0,
+                             generated == samples };
+        }
+
+        std::uint64_t m_seed;
+        std::vector<std::unique_ptr<Job>> m_jobs;
+
+        Clock::time_point m_start;
+        std::atomic<bool> m_running;
+    };
+}
\ No newline at end of file
@@ -30,6 +30,8 @@
 #include <sstream>
 #include <iostream>
 
+#include "CharSet.hpp"
+
 namespace regen
 {
     struct Token
@@ -54,7 +56,7 @@ namespace regen
         };
 
         EType type;
-        char data;
+        char32_t data;
     };
 
     inline std::string token2str( Token::EType type )
@@ -93,7 +95,7 @@ namespace regen
         throw std::logic_error("unknown token type");
     }
 
-    inline Token::EType charToToken( char c )
+    inline Token::EType charToToken( char32_t c )
     {
         if( c == '.' )
             return Token::DOT;
@@ -124,7 +126,7 @@ namespace regen
         else
             return Token::CHAR;
 
-        throw std::runtime_error("unknown token '" + std::string(1, c) + "'");
+        throw std::runtime_error("unknown token '" + toUtf8(c) + "'");
     }
 
     /**
@@ -185,34 +187,55 @@ namespace regen
         std::size_t m_i = 0;
     };
 
-    inline char readHexChar( std::string str )
+    inline char32_t readHexChar( std::string str )
     {
-        str = "0" + str; // 0x..
-
-        char res = '0';
+        str = "0x" + str;
 
-        int num;
+        unsigned long num;
         std::stringstream ss;
         ss << std::hex << str;
         ss >> num;
 
-        if( ss.fail() )
+        if( ss.fail() || !ss.eof() || num > s_maxCodePoint || ( num >= 0xD800 && num <= 0xDFFF ) )
         {
             str[0] = '\\';
             throw std::runtime_error( "Error parsing hex character: '" + str + "'" );
         }
 
-        res = static_cast<char>( num );
+        return static_cast<char32_t>( num );
+    }
+
+    /**
+     * reads the hex escape following "\x" at str[i]: either two hex digits (\x20)
+     * or any number of hex digits in braces (\x{4E00}), and advances i past it
+     * 
+     * @return the escaped code point
+     */
+    inline char32_t readHexEscape( const std::string& str, std::size_t& i )
+    {
+        if( i < str.size() && str[i] == '{' )
+        {
+            auto close = str.find( '}', i );
+            if( close == std::string::npos )
+                throw std::runtime_error( "Expected '}' after '\\x{'" );
+            auto res = readHexChar( str.substr( i+1, close-i-1 ) );
+            i = close + 1;
+            return res;
+        }
 
+        auto res = readHexChar( str.substr( i, 2 ) );
+        i += 2;
         return res;
     }
 
     /**
-     * reads a string containing a regular expression
+     * reads a UTF-8 string containing a regular expression
      * and creates a token list that can be used with the parser
      * 
      * @param str string to read
      * 
+     * @throw std::runtime_error invalid UTF-8 or escape sequence
+     * 
      * @return list of tokens in the string
      */
     inline TokenList lexer( const std::string& str )
@@ -221,7 +244,6 @@ namespace regen
         TokenList res;
 
         std::size_t i = 0;
-        std::size_t startOfChar = std::string::npos;
 
         while( i < str.size() )
         {
@@ -230,21 +252,22 @@ namespace regen
                 ++i;
 
                 if( charClassesSet.count( str[i] ) )
-                    res.push_back( Token{Token::CHARCLASS, str[i]} );
+                    res.push_back( Token{Token::CHARCLASS, static_cast<char32_t>( str[i++] )} );
                 else if( str[i] == 'x' )
-                    res.push_back( Token{Token::CHAR, readHexChar(str.substr(i, 3))} );
+                {
+                    ++i;
+                    res.push_back( Token{Token::CHAR, readHexEscape( str, i )} );
+                }
                 else
-                    res.push_back( Token{Token::CHAR, str[i]} );
+                    res.push_back( Token{Token::CHAR, readUtf8( str, i )} );
 
-                ++i;
                 continue;
             }
 
-            auto tokenType = charToToken( str[i] );
+            auto c = readUtf8( str, i );
+            auto tokenType = charToToken( c );
 
-            res.push_back( Token{tokenType, str[i]} );
-            
-            ++i;
+            res.push_back( Token{tokenType, c} );
         }
 
         return res;
@@ -0,0 +1,396 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Pattern.hpp"
+#include "ThreadPool.hpp"
+
+namespace regen
+{
+    /**
+     * Concurrent hash-consing table of ast nodes
+     * 
+     * Given to parsers as their Interner, it replaces each node by the first identical node it was given:
+     * same characters, same sets, same literal tables, and subtrees whose children are the same nodes.
+     * Since parsers intern the nodes bottom-up, identical subtrees are found by comparing their direct children only.
+     * 
+     * The table is split in shards with a mutex each, parsers running in several threads rarely wait for each other.
+     */
+    class NodeTable : public Interner
+    {
+    public:
+        struct Stats
+        {
+            /** number of nodes given to the table */
+            std::size_t nodes;
+
+            /** number of nodes replaced by an identical one */
+            std::size_t sharedNodes;
+
+            /** estimate of the memory freed by replacing nodes, in bytes */
+            std::size_t bytesSaved;
+        };
+
+        std::shared_ptr<const BasicReSub> intern( std::shared_ptr<const BasicReSub> node ) override
+        {
+            std::string key;
+            std::size_t footprint = s_overhead;
+            if( auto ptr = dynamic_cast<const Char*>( node.get() ) )
+            {
+                key += 'c';
+                append( key, ptr->c );
+                footprint += sizeof( Char );
+            }
+            else if( dynamic_cast<const Any*>( node.get() ) )
+            {
+                key += 'a';
+                footprint += sizeof( Any );
+            }
+            else if( auto ptr = dynamic_cast<const Set*>( node.get() ) )
+            {
+                key += ptr->negative ? 'S' : 's';
+                for( auto& interval : ptr->chars.intervals() )
+                {
+                    append( key, interval.first );
+                    append( key, interval.last );
+                }
+                footprint += sizeof( Set ) + ptr->chars.intervals().capacity() * sizeof( CharSet::Interval );
+            }
+            else if( auto ptr = dynamic_cast<const Reference*>( node.get() ) )
+            {
+                key += 'r';
+                key += ptr->name;
+                footprint += sizeof( Reference ) + ptr->name.capacity();
+            }
+            else if( auto ptr = dynamic_cast<const Group*>( node.get() ) )
+            {
+                key += 'g';
+                append( key, ptr->re );
+                footprint += sizeof( Group ) + size( ptr->re );
+            }
+            else if( auto ptr = dynamic_cast<const Star*>( node.get() ) )
+            {
+                key += '*';
+                append( key, ptr->re.get() );
+                footprint += sizeof( Star );
+            }
+            else if( auto ptr = dynamic_cast<const Plus*>( node.get() ) )
+            {
+                key += '+';
+                append( key, ptr->re.get() );
+                footprint += sizeof( Plus );
+            }
+            else if( auto ptr = dynamic_cast<const Question*>( node.get() ) )
+            {
+                key += '?';
+                append( key, ptr->re.get() );
+                footprint += sizeof( Question );
+            }
+            else if( auto ptr = dynamic_cast<const NumericRange*>( node.get() ) )
+            {
+                key += ptr->open ? 'N' : 'n';
+                append( key, ptr->min );
+                append( key, ptr->max );
+                append( key, ptr->re.get() );
+                footprint += sizeof( NumericRange );
+            }
+            else
+                return node;
+
+            return find( std::move( key ), std::move( node ), footprint );
+        }
+
+        std::shared_ptr<const Literals> intern( std::shared_ptr<const Literals> literals ) override
+        {
+            std::string key( 1, 'l' );
+            for( auto offset : literals->offsets )
+                append( key, offset );
+            key += literals->data;
+
+            const std::size_t footprint = s_overhead + sizeof( Literals ) + literals->data.capacity()
+                                        + literals->offsets.capacity() * sizeof( std::uint32_t );
+            return find( std::move( key ), std::move( literals ), footprint );
+        }
+
+        /** interns the root of an ast, so that identical patterns share the whole ast */
+        std::shared_ptr<const Re> intern( std::shared_ptr<const Re> re )
+        {
+            std::string key( 1, 'R' );
+            append( key, *re );
+            const std::size_t footprint = s_overhead + sizeof( Re ) + size( *re );
+            return find( std::move( key ), std::move( re ), footprint );
+        }
+
+        Stats stats() const
+        {
+            return Stats{ m_nodes.load(), m_sharedNodes.load(), m_bytesSaved.load() };
+        }
+
+    private:
+        enum : std::size_t
+        {
+            s_shards = 64,
+
+            /** control block of a shared_ptr */
+            s_overhead = 2 * sizeof( void* )
+        };
+
+        struct Shard
+        {
+            std::mutex mutex;
+
+            /** nodes by key, the key of a node being its type, its values and the addresses of its children */
+            std::unordered_map<std::string, std::shared_ptr<const void>> nodes;
+        };
+
+        template<class T>
+        static void append( std::string& key, const T& value )
+        {
+            key.append( reinterpret_cast<const char*>( &value ), sizeof( value ) );
+        }
+
+        static void append( std::string& key, const Re& re )
+        {
+            append( key, re.literals.get() );
+            if( re.literals )
+                return;
+
+            append( key, re.unionRes().size() );
+            for( auto& simpleRe : re.unionRes() )
+            {
+                append( key, simpleRe.concatRes.size() );
+                for( auto& basicRe : simpleRe.concatRes )
+                    append( key, basicRe.sub.get() );
+            }
+        }
+
+        /** @return memory owned by the vectors of a regex, without its (shared) nodes */
+        static std::size_t size( const Re& re )
+        {
+            if( re.literals )
+                return 0;
+
+            std::size_t res = re.unionRes().capacity() * sizeof( SimpleRe );
+            for( auto& simpleRe : re.unionRes() )
+                res += simpleRe.concatRes.capacity() * sizeof( BasicRe );
+            return res;
+        }
+
+        template<class T>
+        std::shared_ptr<const T> find( std::string key, std::shared_ptr<const T> node, std::size_t footprint )
+        {
+            m_nodes.fetch_add( 1, std::memory_order_relaxed );
+
+            Shard& shard = m_shards[std::hash<std::string>()( key ) % s_shards];
+            std::lock_guard<std::mutex> lock( shard.mutex );
+            auto it = shard.nodes.find( key );
+            if( it == shard.nodes.end() )
+            {
+                shard.nodes.emplace( std::move( key ), node );
+                return node;
+            }
+
+            m_sharedNodes.fetch_add( 1, std::memory_order_relaxed );
+            m_bytesSaved.fetch_add( footprint, std::memory_order_relaxed );
+            return std::static_pointer_cast<const T>( it->second );
+        }
+
+        std::array<Shard, s_shards> m_shards;
+        std::atomic<std::size_t> m_nodes{ 0 };
+        std::atomic<std::size_t> m_sharedNodes{ 0 };
+        std::atomic<std::size_t> m_bytesSaved{ 0 };
+    };
+
+    /**
+     * Patterns compiled together by compileLibrary
+     */
+    struct Library
+    {
+        struct Report
+        {
+            /** number of patterns compiled */
+            std::size_t patterns;
+
+            /** number of threads of the pool */
+            std::size_t threads;
+
+            /** seconds taken by the compilation */
+            double seconds;
+
+            /** number of ast nodes built by the parsers */
+            std::size_t nodes;
+
+            /** number of nodes replaced by an identical node of another place or pattern */
+            std::size_t sharedNodes;
+
+            /** estimate of the memory saved by sharing nodes, in bytes */
+            std::size_t bytesSaved;
+
+            /** number of negated or restricted sets resolved for all the patterns, identical sets being resolved once */
+            std::size_t resolvedSets;
+        };
+
+        /** in the order of their regexes, built in place by the threads of the pool */
+        std::vector<std::unique_ptr<Pattern>> patterns;
+
+        Report report;
+    };
+
+    /**
+     * compiles many patterns at once on a pool of threads, e.g. a library of patterns loaded at startup
+     * 
+     * the patterns are parsed into a single table of nodes: identical sets, literal tables and subtrees,
+     * in a pattern or across patterns, are built once and shared, and so are the asts of identical regexes.
+     * Since they are shared, identical nodes of a pattern are one and the same for its Weighting and Coverage,
+     * which are keyed by node, and the sets resolved with the generator's settings are kept once for all
+     * the patterns (@see Pattern::resolvedSets). Strings generated from a pattern of a library are the same as those
+     * generated from the pattern compiled alone.
+     * 
+     * must not be called from a task of the pool, which waits for the compilation
+     * 
+     * @code
+     * regen::ThreadPool pool;
+     * auto library = regen::compileLibrary( { "[a-z]+@example\\.com", "[0-9]{4}-[0-9]{2}-[0-9]{2}" }, pool );
+     * std::string email = library.patterns[0]->generate();
+     * @endcode
+     * 
+     * @param regexes regular expressions
+     * @param pool threads compiling the patterns
+     * @param generator Generator used by each pattern. @see Generator for default parameters
+     * @param limits the worst case of each regex must fit in maxBytes and maxVisits
+     * 
+     * @throw std::runtime_error error processing a regex, with the index of the first invalid regex
+     * @throw BudgetExceeded the worst case of a regex exceeds the limits
+     * 
+     * @return the patterns, and the time and memory saved by the compilation
+     */
+    inline Library compileLibrary( const std::vector<std::string>& regexes,
+                                   ThreadPool& pool,
+                                   const Generator& generator = Generator(),
+                                   const Budget& limits = Budget() )
+    {
+        // patterns compiled by a task: enough to amortize the task, few enough to balance the threads
+        const std::size_t maxChunk = 256;
+
+        const auto start = std::chrono::steady_clock::now();
+        NodeTable table;
+        Library res;
+        res.patterns.resize( regexes.size() );
+        auto& compiled = res.patterns;
+
+        // runs task( i ) for each regex on the pool, by chunks which stop at their first error:
+        // the first failed chunk has the first invalid regex
+        const std::size_t chunk = std::max<std::size_t>( 1, std::min( maxChunk, regexes.size() / ( 4 * pool.size() ) ) );
+        auto forEach = [&regexes, &pool, chunk]( const std::function<void( std::size_t )>& task )
+        {
+            std::vector<std::future<void>> futures;
+            for( std::size_t begin = 0; begin < regexes.size(); begin += chunk )
+            {
+                const std::size_t end = std::min( regexes.size(), begin + chunk );
+                futures.push_back( pool.submit( [&task, begin, end]
+                {
+                    for( std::size_t i = begin; i < end; ++i )
+                    {
+                        const std::string prefix = "pattern " + std::to_string( i ) + ": ";
+                        try
+                        {
+                            task( i );
+                        }
+                        catch( const BudgetExceeded& ex )
+                        {
+                            throw BudgetExceeded( ex.resource(), prefix + ex.what() );
+                        }
+                        catch( const std::exception& ex )
+                        {
+                            throw std::runtime_error( prefix + ex.what() );
+                        }
+                    }
+                } ) );
+            }
+
+            std::exception_ptr error;
+            for( auto& future : futures )
+            {
+                try
+                {
+                    future.get();
+                }
+                catch( ... )
+                {
+                    if( !error )
+                        error = std::current_exception();
+                }
+            }
+            if( error )
+                std::rethrow_exception( error );
+        };
+
+        // the regexes are parsed into the table, and their sets resolved once per chunk
+        std::vector<std::shared_ptr<const Re>> asts( regexes.size() );
+        std::vector<Generator::ResolvedSets> chunkSets( ( regexes.size() + chunk - 1 ) / chunk );
+        forEach( [&regexes, &generator, &table, &asts, &chunkSets, chunk]( std::size_t i )
+        {
+            auto tokens = lexer( regexes[i] );
+            asts[i] = table.intern( std::make_shared<const Re>( Parser( &table ).parse( tokens ) ) );
+            generator.resolve( *asts[i], chunkSets[i / chunk] );
+        } );
+
+        // identical sets are a single node of the table, hence a single entry shared by all the patterns
+        auto sets = std::make_shared<Generator::ResolvedSets>();
+        for( Generator::ResolvedSets& resolved : chunkSets )
+        {
+            sets->insert( std::make_move_iterator( resolved.begin() ), std::make_move_iterator( resolved.end() ) );
+            resolved.clear();
+        }
+
+        forEach( [&regexes, &generator, &limits, &asts, &sets, &compiled]( std::size_t i )
+        {
+            compiled[i].reset( new Pattern( regexes[i], std::move( asts[i] ), generator, limits, sets ) );
+        } );
+
+        const NodeTable::Stats stats = table.stats();
+        res.report.patterns = regexes.size();
+        res.report.threads = pool.size();
+        res.report.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        res.report.nodes = stats.nodes;
+        res.report.sharedNodes = stats.sharedNodes;
+        res.report.bytesSaved = stats.bytesSaved;
+        res.report.resolvedSets = sets->size();
+        return res;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Dictionary.hpp"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define REGEN_MAPPED_DICTIONARY
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace regen
+{
+    /**
+     * maps and indexes a dictionary file, instead of reading it: large dictionaries are not copied
+     * and their pages are shared by the processes mapping them
+     * 
+     * the file is only mapped on POSIX systems, elsewhere it is read as by Dictionary's constructor
+     * 
+     * @param path path of the file
+     * @param format format of the lines
+     * 
+     * @throw std::runtime_error the file cannot be mapped, has no word or a line is invalid
+     * 
+     * @return the dictionary, to be registered on a Generator (@see Generator::addDictionary)
+     */
+    inline std::shared_ptr<const Dictionary> mapDictionary( const std::string& path, Dictionary::EFormat format = Dictionary::WORDS )
+    {
+#ifdef REGEN_MAPPED_DICTIONARY
+        const int fd = ::open( path.c_str(), O_RDONLY );
+        if( fd < 0 )
+            throw std::runtime_error( "cannot open dictionary '" + path + "': " + std::strerror( errno ) );
+
+        struct stat st;
+        if( ::fstat( fd, &st ) != 0 || st.st_size == 0 )
+        {
+            ::close( fd );
+            throw std::runtime_error( "dictionary '" + path + "' is empty or cannot be read" );
+        }
+
+        const std::size_t size = static_cast<std::size_t>( st.st_size );
+        void* data = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        const int error = errno;
+        ::close( fd );
+        if( data == MAP_FAILED )
+            throw std::runtime_error( "cannot map dictionary '" + path + "': " + std::strerror( error ) );
+
+        std::shared_ptr<const void> mapping( data, [size]( const void* ptr ) { ::munmap( const_cast<void*>( ptr ), size ); } );
+        return std::make_shared<const Dictionary>( path, boost::string_view( static_cast<const char*>( data ), size ),
+                                                   std::move( mapping ), format );
+#else
+        return std::make_shared<const Dictionary>( path, format );
+#endif
+    }
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstdint>
+
+#include <boost/utility/string_view.hpp>
+
+#include "Automaton.hpp"
+
+namespace regen
+{
+    /**
+     * Checks whether strings match a regular expression
+     * 
+     * The regex is compiled into an NFA, which is lazily turned into a DFA
+     * with one transition per byte class as strings are matched: once the states
+     * a string goes through are known, matching costs one table lookup per byte.
+     * The whole string must match, as with std::regex_match.
+     * 
+     * The matcher is not thread safe, use one per thread.
+     */
+    class Matcher
+    {
+    public:
+        /**
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param maxCachedStates number of DFA states kept before the cache is flushed
+         */
+        explicit Matcher( const Re& re, std::size_t maxCachedStates = 4096 )
+        : m_nfa( Nfa::regex( re ) ),
+        m_classes( m_nfa.byteClasses() ),
+        m_classCount( m_nfa.classCount() ),
+        m_maxCachedStates( maxCachedStates )
+        {
+            flush();
+        }
+
+        /**
+         * @return true if the whole string matches the regex
+         */
+        bool matches( boost::string_view str ) const
+        {
+            std::int32_t state = s_start;
+            const std::int32_t* transitions = m_transitions.data();
+            const std::size_t classCount = m_classCount;
+
+            for( unsigned char c : str )
+            {
+                const std::size_t cls = m_classes[c];
+                std::int32_t next = transitions[state * classCount + cls];
+                if( next < 0 )
+                {
+                    next = computeTransition( state, cls );
+                    transitions = m_transitions.data();
+                }
+                if( next == s_dead )
+                    return false;
+                state = next;
+            }
+
+            return m_accepting[state];
+        }
+
+        /**
+         * checks a batch of strings
+         * 
+         * @return the indices of the strings which do not match
+         */
+        std::vector<std::size_t> validate( const std::vector<std::string>& samples ) const
+        {
+            std::vector<std::size_t> res;
+            for( std::size_t i = 0; i < samples.size(); ++i )
+            {
+                if( !matches( samples[i] ) )
+                    res.push_back( i );
+            }
+            return res;
+        }
+
+    private:
+        enum : std::int32_t
+        {
+            s_dead = 0,
+            s_start = 1
+        };
+
+        std::int32_t addState( Nfa::StateSet&& states ) const
+        {
+            auto it = m_ids.find( states );
+            if( it != m_ids.end() )
+                return it->second;
+
+            const std::int32_t id = static_cast<std::int32_t>( m_accepting.size() );
+            m_accepting.push_back( m_nfa.accepts( states ) );
+            m_transitions.resize( m_transitions.size() + m_classCount, -1 );
+            m_states.push_back( states );
+            m_ids.emplace( std::move( states ), id );
+            return id;
+        }
+
+        std::int32_t computeTransition( std::int32_t state, std::size_t cls ) const
+        {
+            Nfa::StateSet next = m_nfa.step( m_states[state], m_nfa.byteClass( cls ).first );
+
+            if( m_accepting.size() >= m_maxCachedStates )
+            {
+                // start over, keeping the current state
+                Nfa::StateSet current = m_states[state];
+                flush();
+                state = addState( std::move( current ) );
+            }
+
+            const std::int32_t id = addState( std::move( next ) );
+            m_transitions[state * m_classCount + cls] = id;
+            return id;
+        }
+
+        void flush() const
+        {
+            m_ids.clear();
+            m_states.clear();
+            m_accepting.clear();
+            m_transitions.clear();
+
+            addState( Nfa::StateSet() );
+            addState( m_nfa.start() );
+        }
+
+        Nfa m_nfa;
+
+        std::array<unsigned char, 256> m_classes;
+        std::size_t m_classCount;
+        std::size_t m_maxCachedStates;
+
+        /** DFA states computed so far, s_dead is the empty set */
+        mutable std::map<Nfa::StateSet, std::int32_t> m_ids;
+        mutable std::vector<Nfa::StateSet> m_states;
+        mutable std::vector<bool> m_accepting;
+
+        /** m_transitions[state * m_classCount + class], -1 when not computed yet */
+        mutable std::vector<std::int32_t> m_transitions;
+    };
+}
\ No newline at end of file
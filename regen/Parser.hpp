@@ -25,8 +25,13 @@
 #pragma once
 
 #include <memory>
+#include <cstdint>
+#include <limits>
+
+#include "CharSet.hpp"
 
 #include <boost/lexical_cast.hpp>
+#include <boost/utility/string_view.hpp>
 
 namespace regen
 {
@@ -78,27 +83,57 @@ namespace regen
     */
     struct SimpleRe;
 
-    struct Re
+    /**
+     * Literal strings packed in a single buffer, e.g. the alternatives of (alice|bob|carol)
+     */
+    struct Literals
     {
-        std::vector<SimpleRe> unionRes;
-    };
+        /** literal i is data[offsets[i], offsets[i + 1]) (UTF-8 encoded) */
+        std::string data;
+        std::vector<std::uint32_t> offsets{ 0 };
 
-    struct SetItem
-    {
-        virtual ~SetItem() {};
-    };
+        std::size_t size() const { return offsets.size() - 1; }
 
-    struct Range : public SetItem
-    {
-        Range( char s, char e ) : start( s ), end( e ) {}
-        char start;
-        char end;
+        boost::string_view operator[]( std::size_t i ) const
+        {
+            return boost::string_view( data.data() + offsets[i], offsets[i + 1] - offsets[i] );
+        }
+
+        void push_back( boost::string_view literal )
+        {
+            if( data.size() + literal.size() > std::numeric_limits<std::uint32_t>::max() )
+                throw std::runtime_error( "too many literal alternatives" );
+            data.append( literal.data(), literal.size() );
+            offsets.push_back( static_cast<std::uint32_t>( data.size() ) );
+        }
     };
 
-    struct CharItem : public SetItem
+    struct Re
     {
-        CharItem( char c ) : c( c ) {}
-        char c;
+        /**
+         * alternation of at least 2 literals, stored packed instead of one SimpleRe per alternative
+         * to keep dictionary patterns with many alternatives small, null otherwise
+         */
+        std::shared_ptr<const Literals> literals;
+
+        /** @return number of alternatives */
+        std::size_t size() const { return literals ? literals->size() : m_unionRes.size(); }
+
+        /**
+         * @return the alternatives
+         * @throw std::logic_error if the alternatives are packed in literals, to be checked first
+         */
+        const std::vector<SimpleRe>& unionRes() const
+        {
+            if( literals )
+                throw std::logic_error( "the alternatives are packed in Re::literals" );
+            return m_unionRes;
+        }
+
+    private:
+        friend class Parser;
+
+        std::vector<SimpleRe> m_unionRes;
     };
 
     struct BasicReSub
@@ -113,31 +148,34 @@ namespace regen
 
     struct Star : public BasicReSub
     {
-        Star(std::unique_ptr<ElementaryRe>&& er) : re(std::move(er)) {}
-        std::unique_ptr<ElementaryRe> re;
+        Star(std::shared_ptr<const ElementaryRe> er) : re(std::move(er)) {}
+        std::shared_ptr<const ElementaryRe> re;
     };
 
     struct Plus : public BasicReSub
     {
-        Plus(std::unique_ptr<ElementaryRe>&& er) : re(std::move(er)) {}
-        std::unique_ptr<ElementaryRe> re;
+        Plus(std::shared_ptr<const ElementaryRe> er) : re(std::move(er)) {}
+        std::shared_ptr<const ElementaryRe> re;
     };
 
     struct Question : public BasicReSub
     {
-        Question(std::unique_ptr<ElementaryRe>&& er) : re(std::move(er)) {}
-        std::unique_ptr<ElementaryRe> re;
+        Question(std::shared_ptr<const ElementaryRe> er) : re(std::move(er)) {}
+        std::shared_ptr<const ElementaryRe> re;
     };
 
     struct NumericRange : public BasicReSub
     {
-        NumericRange(std::unique_ptr<ElementaryRe>&& er, std::size_t mi, std::size_t ma)
+        NumericRange(std::shared_ptr<const ElementaryRe> er, std::size_t mi, std::size_t ma)
         : re(std::move(er)), min(mi), max(ma)
         {}
 
-        std::unique_ptr<ElementaryRe> re;
+        std::shared_ptr<const ElementaryRe> re;
         std::size_t min;
         std::size_t max;
+
+        /** {n,} has no upper bound in the regex, max is only the bound used for the generation */
+        bool open = false;
     };
 
     struct Group : public ElementaryRe
@@ -151,19 +189,26 @@ namespace regen
 
     struct Char : public ElementaryRe
     {
-        Char( char c ) : c( c ) {}
-        char c;
+        Char( char32_t c ) : c( c ) {}
+        char32_t c;
     };
 
     struct Set : public ElementaryRe
     {
         bool negative = false;
-        std::vector<std::unique_ptr<SetItem>> items;
+        CharSet chars;
+    };
+
+    /** {name}: a word of the dictionary registered with that name on the Generator */
+    struct Reference : public ElementaryRe
+    {
+        std::string name;
     };
 
     struct BasicRe
     {
-        std::unique_ptr<BasicReSub> sub;
+        /** nodes are immutable once parsed, identical ones may be shared between asts (@see Interner) */
+        std::shared_ptr<const BasicReSub> sub;
     };
 
     struct SimpleRe
@@ -171,6 +216,35 @@ namespace regen
         std::vector<BasicRe> concatRes;
     };
 
+    /**
+     * @param quantifier *, +, ? or {n,m} node of the ast
+     * 
+     * @return the elementary regex repeated by the quantifier
+     */
+    inline const ElementaryRe* quantified( const BasicReSub& quantifier )
+    {
+        if( auto ptr = dynamic_cast<const Star*>( &quantifier ) )
+            return ptr->re.get();
+        if( auto ptr = dynamic_cast<const Plus*>( &quantifier ) )
+            return ptr->re.get();
+        if( auto ptr = dynamic_cast<const Question*>( &quantifier ) )
+            return ptr->re.get();
+        return static_cast<const NumericRange*>( &quantifier )->re.get();
+    }
+
+    /**
+     * Receives each node built by a Parser, once its children are built,
+     * and returns the node to use instead: the same or an identical one
+     */
+    class Interner
+    {
+    public:
+        virtual ~Interner() {}
+
+        virtual std::shared_ptr<const BasicReSub> intern( std::shared_ptr<const BasicReSub> node ) = 0;
+        virtual std::shared_ptr<const Literals> intern( std::shared_ptr<const Literals> literals ) = 0;
+    };
+
     /**
      * Parses a list of tokens containing a regex into an AST.
      * 
@@ -180,6 +254,14 @@ namespace regen
     class Parser
     {
     public:
+        /**
+         * @param interner receives the nodes of the parsed asts to share identical nodes, optional
+         */
+        explicit Parser( Interner* interner = nullptr )
+        : m_interner( interner )
+        {
+        }
+
         /**
          * parses a list of tokens containing a regex into an AST.
          * 
@@ -212,6 +294,14 @@ namespace regen
         }
 
     private:
+        template<class T>
+        std::shared_ptr<const T> intern( std::shared_ptr<const T> node ) const
+        {
+            if( !m_interner )
+                return node;
+            return std::static_pointer_cast<const T>( m_interner->intern( std::shared_ptr<const BasicReSub>( std::move( node ) ) ) );
+        }
+
         std::unique_ptr<Group> parseGroup( TokenList& tokens )
         {
             std::unique_ptr<Group> res = std::make_unique<Group>();
@@ -223,35 +313,30 @@ namespace regen
             return res;
         }
 
-        std::unique_ptr<SetItem> parsetSetItem( TokenList& tokens )
+        CharSet parsetSetItem( TokenList& tokens )
         {
             // <set-items>	::=	<set-item> | <set-item> <set-items>
             // <set-items>	::=	<range> | <char>
             // <range>	::=	<char> "-" <char>
-            std::unique_ptr<SetItem> res;
-
             if( tokens.peak().type == Token::CHAR && tokens.peak(1).type == Token::MINUS )
             {
-                char start = tokens.eat().data;
+                char32_t start = tokens.eat().data;
                 tokens.eat();
-                char end = tokens.eat().data;
+                char32_t end = tokens.eat().data;
 
                 if( end < start )
-                    throw std::runtime_error( "Invalid range: " + std::string(1, start) + "-" + std::string(1, end) );
+                    throw std::runtime_error( "Invalid range: " + toUtf8(start) + "-" + toUtf8(end) );
 
-                res = std::make_unique<Range>( start, end );
-            }
-            else
-            {
-                res = std::make_unique<CharItem>( tokens.eat().data );
+                return CharSet( start, end );
             }
 
-            return res;
+            auto c = tokens.eat().data;
+            return CharSet( c, c );
         }
 
-        std::vector<std::unique_ptr<SetItem>> expandCharClass( TokenList& tokens )
+        CharSet expandCharClass( TokenList& tokens )
         {
-            std::vector<std::unique_ptr<SetItem>> res;
+            CharSet res;
 
             // \w	A-Za-z0-9_
             // \d   0-9
@@ -267,33 +352,29 @@ namespace regen
 
             if( tok.data == 'w' )
             {
-                res.push_back( std::make_unique<Range>( 'A', 'Z' ) );
-                res.push_back( std::make_unique<Range>( 'a', 'z' ) );
-                res.push_back( std::make_unique<Range>( '0', '9' ) );
-                res.push_back( std::make_unique<CharItem>( '_' ) );
+                res.insert( 'A', 'Z' );
+                res.insert( 'a', 'z' );
+                res.insert( '0', '9' );
+                res.insert( '_', '_' );
             }
             else if( tok.data == 'd' )
             {
-                res.push_back( std::make_unique<Range>( '0', '9' ) );
+                res.insert( '0', '9' );
             }
             else if( tok.data == 's' )
             {
-                res.push_back( std::make_unique<CharItem>( '\t' ) );
-                res.push_back( std::make_unique<CharItem>( '\r' ) );
-                res.push_back( std::make_unique<CharItem>( '\n' ) );
-                res.push_back( std::make_unique<CharItem>( '\v' ) );
-                res.push_back( std::make_unique<CharItem>( '\f' ) );
+                res.insert( '\t', '\r' ); // \t \n \v \f \r
             }
             else if( tok.data == 't' )
-                res.push_back( std::make_unique<CharItem>( '\t' ) );
+                res.insert( '\t', '\t' );
             else if( tok.data == 'r' )
-                res.push_back( std::make_unique<CharItem>( '\r' ) );
+                res.insert( '\r', '\r' );
             else if( tok.data == 'n' )
-                res.push_back( std::make_unique<CharItem>( '\n' ) );
+                res.insert( '\n', '\n' );
             else if( tok.data == 'v' )
-                res.push_back( std::make_unique<CharItem>( '\v' ) );
+                res.insert( '\v', '\v' );
             else if( tok.data == 'f' )
-                res.push_back( std::make_unique<CharItem>( '\f' ) );
+                res.insert( '\f', '\f' );
 
             return res;
         }
@@ -320,12 +401,9 @@ namespace regen
             while( tokens.peak().type != Token::CBRACKET )
             {
                 if( tokens.peak().type == Token::CHAR )
-                    res->items.push_back( parsetSetItem( tokens ) );
+                    res->chars.insert( parsetSetItem( tokens ) );
                 else // CHARCLASS
-                {
-                    auto vRanges = expandCharClass( tokens );
-                    std::move(vRanges.begin(), vRanges.end(), std::back_inserter(res->items));
-                }
+                    res->chars.insert( expandCharClass( tokens ) );
             }
 
             tokens.eat( "]" );
@@ -333,11 +411,11 @@ namespace regen
             return res;
         }
 
-        std::unique_ptr<ElementaryRe> parseElementaryRe( TokenList& tokens )
+        std::shared_ptr<const ElementaryRe> parseElementaryRe( TokenList& tokens )
         {
             // <elementary-RE>	::=	<group> | <any> ( | <eos> ) | <char> | <set>
 
-            std::unique_ptr<ElementaryRe> res;
+            std::shared_ptr<ElementaryRe> res;
 
             if( tokens.peak().type == Token::OPAREN )
             {
@@ -355,30 +433,80 @@ namespace regen
             else if( tokens.peak().type == Token::CHARCLASS )
             {
                 auto set = std::make_unique<Set>();
-                set->items = expandCharClass( tokens );
+                set->chars = expandCharClass( tokens );
                 res = std::move( set );
             }
             else if( tokens.peak().type == Token::CHAR || tokens.peak().type == Token::MINUS )
             {
                 res = std::make_unique<Char>( tokens.eat().data );
             }
+            else if( tokens.peak().type == Token::OSB && !quantifier( tokens ) )
+            {
+                res = parseReference( tokens );
+            }
             else
             {
                 throw std::logic_error( "Expected <" + token2str(Token::OPAREN) + "> or <"
                                                     + token2str(Token::DOT) + "> or <"
                                                     + token2str(Token::OBRACKET) + "> or <"
                                                     + token2str(Token::CHARCLASS) + "> or <"
+                                                    + token2str(Token::OSB) + "> or <"
                                                     + token2str(Token::CHAR) + ">" );
             }
 
+            return intern<ElementaryRe>( std::move( res ) );
+        }
+
+        std::unique_ptr<Reference> parseReference( TokenList& tokens )
+        {
+            // <reference>	::=	"{" <name> "}"
+            // <name>	::=	[A-Za-z_][A-Za-z0-9_]*
+
+            auto res = std::make_unique<Reference>();
+
+            tokens.eat( "{" );
+            while( !tokens.eof() && tokens.peak().type == Token::CHAR )
+            {
+                const char32_t c = tokens.peak().data;
+                const bool letter = ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_';
+                if( !letter && ( res->name.empty() || c < '0' || c > '9' ) )
+                    break;
+                res->name += static_cast<char>( tokens.eat().data );
+            }
+            if( res->name.empty() )
+                throw std::runtime_error( "Expected <dictionary name> after <" + token2str(Token::OSB) + ">" );
+
+            auto tok = tokens.eat( "}" );
+            if( tok.type != Token::CSB )
+                throw std::runtime_error( "expected <" + token2str(Token::CSB) + "> got <" + token2str(tok.type) + ">" );
+
             return res;
         }
 
+        /**
+         * @return true if the next tokens are a quantifier: *, +, ? or {n,m}
+         *         (a brace followed by anything but a digit opens a dictionary reference)
+         */
+        static bool quantifier( const TokenList& tokens )
+        {
+            if( tokens.eof() )
+                return false;
+
+            const Token& tok = tokens.peak();
+            if( tok.type == Token::STAR || tok.type == Token::PLUS || tok.type == Token::QUESTION )
+                return true;
+            if( tok.type != Token::OSB || tokens.eof( 1 ) )
+                return false;
+
+            const Token& next = tokens.peak( 1 );
+            return next.type == Token::CHAR && next.data >= '0' && next.data <= '9';
+        }
+
         int readInteger( TokenList& tokens )
         {
             std::string str;
             while( tokens.peak().type == Token::CHAR && tokens.peak().data >= '0' && tokens.peak().data <= '9' )
-                str += std::string(1,tokens.eat().data);
+                str += static_cast<char>( tokens.eat().data );
             
             try
             {
@@ -399,34 +527,38 @@ namespace regen
             BasicRe res;
 
             auto elementaryRe = parseElementaryRe( tokens );
-            if( !tokens.eof() )
+            if( quantifier( tokens ) )
             {
-                if( tokens.peak().data == '*' )
+                if( tokens.peak().type == Token::STAR )
                 {
                     tokens.eat();
-                    res.sub = std::make_unique<Star>( std::move(elementaryRe) );
+                    res.sub = intern<BasicReSub>( std::make_shared<Star>( std::move(elementaryRe) ) );
                 }
-                else if( tokens.peak().data == '+' )
+                else if( tokens.peak().type == Token::PLUS )
                 {
                     tokens.eat();
-                    res.sub = std::make_unique<Plus>( std::move(elementaryRe) );
+                    res.sub = intern<BasicReSub>( std::make_shared<Plus>( std::move(elementaryRe) ) );
                 }
-                else if( tokens.peak().data == '?' )
+                else if( tokens.peak().type == Token::QUESTION )
                 {
                     tokens.eat();
-                    res.sub = std::make_unique<Question>( std::move(elementaryRe) );
+                    res.sub = intern<BasicReSub>( std::make_shared<Question>( std::move(elementaryRe) ) );
                 }
-                else if( tokens.peak().data == '{' )
+                else
                 {
                     tokens.eat();
                     int min, max;
+                    bool open = false;
                     min = readInteger( tokens );
                     max = min;
                     if( tokens.peak().type == Token::CHAR && tokens.peak().data == ',' )
                     {
                         tokens.eat();
                         if( tokens.peak().type == Token::CSB && tokens.peak().data == '}' )
+                        {
                             max = min + 5;
+                            open = true;
+                        }
                         else
                         {
                             max = readInteger( tokens );
@@ -437,10 +569,10 @@ namespace regen
                     if( tok.data != '}' )
                         throw std::runtime_error( "expected <" + token2str(Token::CSB) + "> got <" + token2str(tok.type) + ">" );
 
-                    res.sub = std::make_unique<NumericRange>( std::move(elementaryRe), min, max );
+                    auto nrange = std::make_shared<NumericRange>( std::move(elementaryRe), min, max );
+                    nrange->open = open;
+                    res.sub = intern<BasicReSub>( std::move( nrange ) );
                 }
-                else
-                    res.sub = std::move(elementaryRe);
             }
             else
                 res.sub = std::move(elementaryRe);
@@ -469,22 +601,83 @@ namespace regen
             return res;
         }
 
+        /**
+         * reads an alternative made of literal characters only
+         * 
+         * @return false and reads nothing if the alternative is not a literal
+         */
+        bool parseLiteral( TokenList& tokens, std::string& literal )
+        {
+            std::size_t n = 0;
+            for( ; !tokens.eof( n ); ++n )
+            {
+                const Token& tok = tokens.peak( n );
+                if( tok.type == Token::PIPE || tok.type == Token::CPAREN )
+                    break;
+                if( tok.type != Token::CHAR && tok.type != Token::MINUS )
+                    return false;
+            }
+            if( n == 0 )
+                return false;
+
+            literal.clear();
+            for( std::size_t i = 0; i < n; ++i )
+                appendUtf8( literal, tokens.eat().data );
+            return true;
+        }
+
+        SimpleRe literalToSimpleRe( const std::string& literal ) const
+        {
+            SimpleRe res;
+            for( std::size_t i = 0; i < literal.size(); )
+            {
+                BasicRe bre;
+                bre.sub = intern<BasicReSub>( std::make_shared<Char>( readUtf8( literal, i ) ) );
+                res.concatRes.push_back( std::move( bre ) );
+            }
+            return res;
+        }
+
         Re parseRe( TokenList& tokens )
         {
             Re res;
 
-            res.unionRes.push_back( parseSimpleRe(tokens) );
+            // literal alternatives are packed as long as all the alternatives are literals
+            std::shared_ptr<Literals> literals = std::make_shared<Literals>();
+            std::string literal;
+            bool packed = true;
 
-            while( !tokens.eof() && tokens.peak().type == Token::PIPE )
+            for( bool first = true; first || ( !tokens.eof() && tokens.peak().type == Token::PIPE ); first = false )
             {
-                tokens.eat();
-                res.unionRes.push_back( parseSimpleRe(tokens) );
+                if( !first )
+                    tokens.eat();
+
+                if( packed && parseLiteral( tokens, literal ) )
+                {
+                    literals->push_back( literal );
+                    continue;
+                }
+
+                if( packed )
+                {
+                    for( std::size_t i = 0; i < literals->size(); ++i )
+                        res.m_unionRes.push_back( literalToSimpleRe( (*literals)[i].to_string() ) );
+                    packed = false;
+                }
+                res.m_unionRes.push_back( parseSimpleRe(tokens) );
             }
 
+            if( packed && literals->size() > 1 )
+                res.literals = m_interner ? m_interner->intern( std::move( literals ) ) : std::move( literals );
+            else if( packed )
+                res.m_unionRes.push_back( literalToSimpleRe( (*literals)[0].to_string() ) );
+
             if( !tokens.eof() && tokens.peak().type != Token::CPAREN ) // hack
                 throw std::runtime_error( "invalid regex caused parsing to stop prematurely" );
 
             return res;
         }
+
+        Interner* m_interner;
     };
 }
\ No newline at end of file
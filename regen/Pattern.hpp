@@ -0,0 +1,233 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include "Generator.hpp"
+#include "Analysis.hpp"
+#include "Shape.hpp"
+
+namespace regen
+{
+    /**
+     * Regular expression compiled once for a generator
+     * 
+     * The ast is immutable and shared between the copies of a pattern, while each
+     * copy has its own generator: copy a pattern (and seed the copy) to generate
+     * from several threads without compiling the regex again.
+     * 
+     * Simple regexes (literals, fixed length sequences, alternations of literals and
+     * single quantified sets) are generated without walking the ast, @see Shape
+     */
+    class Pattern
+    {
+    public:
+        /**
+         * @param regex regular expression
+         * @param generator Generator used to generate the strings. @see Generator for default parameters
+         * 
+         * @throw std::runtime_error error processing the regex (i.e. invalid regex)
+         */
+        explicit Pattern( const std::string& regex, const Generator& generator = Generator() )
+        : Pattern( regex, generator, Budget() )
+        {
+        }
+
+        /**
+         * compiles a regex, rejecting it if the generation could exceed the limits
+         * 
+         * @param regex regular expression
+         * @param generator Generator used to generate the strings. @see Generator for default parameters
+         * @param limits the worst case of the regex (@see Analysis::Stats) must fit in maxBytes and maxVisits,
+         *               the deadline is ignored
+         * 
+         * @throw std::runtime_error error processing the regex (i.e. invalid regex)
+         * @throw BudgetExceeded the worst case of the regex exceeds the limits
+         */
+        Pattern( const std::string& regex, const Generator& generator, const Budget& limits )
+        : Pattern( regex, parse( regex ), generator, limits )
+        {
+        }
+
+        /**
+         * compiles an already parsed regex, e.g. whose nodes are shared with other patterns (@see compileLibrary)
+         * 
+         * @param regex regular expression
+         * @param re ast of the regex
+         * @param generator Generator used to generate the strings. @see Generator for default parameters
+         * @param limits the worst case of the regex must fit in maxBytes and maxVisits
+         * @param sets the sets of the regex already resolved with the settings of the generator,
+         *             e.g. shared by the patterns of a library. Resolved by the pattern when null
+         * 
+         * @throw std::runtime_error error processing the regex
+         * @throw BudgetExceeded the worst case of the regex exceeds the limits
+         */
+        Pattern( const std::string& regex,
+                 std::shared_ptr<const Re> re,
+                 const Generator& generator,
+                 const Budget& limits = Budget(),
+                 std::shared_ptr<const Generator::ResolvedSets> sets = nullptr )
+        : m_regex( regex ),
+        m_re( std::move( re ) ),
+        m_generator( generator ),
+        m_sets( std::move( sets ) )
+        {
+            m_analysis = std::make_shared<const Analysis>( *m_re, m_generator );
+
+            const Analysis::Stats& worst = m_analysis->stats();
+            if( worst.maxLength > limits.maxBytes )
+                throw BudgetExceeded( BudgetExceeded::BYTES, "the strings of the regex can exceed the maximum size" );
+            if( worst.maxCost > static_cast<double>( limits.maxVisits ) )
+                throw BudgetExceeded( BudgetExceeded::VISITS, "the generation of the regex can exceed the maximum number of visited nodes" );
+
+            m_shape = std::make_shared<const Shape>( *m_re, m_generator );
+
+            if( !m_sets )
+            {
+                auto sets = std::make_shared<Generator::ResolvedSets>();
+                m_generator.resolve( *m_re, *sets );
+                m_sets = std::move( sets );
+            }
+
+            // reserve enough for any string, unless that is much more than usual
+            const Analysis::Stats& stats = m_analysis->stats();
+            m_reserve = stats.maxLength <= s_maxReserve ? stats.maxLength
+                                                        : static_cast<std::size_t>( std::ceil( stats.expectedLength ) );
+        }
+
+        /**
+         * @return a random string matching the regular expression
+         */
+        std::string generate() const
+        {
+            std::string res;
+            res.reserve( m_reserve );
+            generate( res );
+            return res;
+        }
+
+        /**
+         * appends a random string matching the regular expression to out
+         */
+        void generate( std::string& out ) const
+        {
+            if( m_shape->kind() == Shape::GENERAL )
+            {
+                Generator::State state{ out, m_generator.m_rng };
+                state.resolved = m_sets.get();
+                m_generator.generate( *m_re, state );
+            }
+            else
+                m_shape->generate( m_generator.m_rng, out );
+        }
+
+        /**
+         * @return a random string matching the regular expression, generated within a budget
+         * 
+         * @throw BudgetExceeded the generation exceeded the budget
+         * 
+         * @see Generator::generate( const Re&, std::string&, const Budget& )
+         */
+        std::string generate( const Budget& budget ) const
+        {
+            std::string res;
+            m_generator.generate( *m_re, res, budget );
+            return res;
+        }
+
+        /**
+         * @return a random string matching the regular expression, the large repetitions
+         *         being generated in chunks by a pool of threads
+         * 
+         * @see Generator::generate( const Re&, ThreadPool&, std::size_t )
+         */
+        std::string generate( ThreadPool& pool ) const
+        {
+            return m_generator.generate( *m_re, pool );
+        }
+
+        /**
+         * writes a random string matching the regular expression to a sink in chunks,
+         * without holding the whole string in memory
+         * 
+         * @see Generator::generate( const Re&, const Generator::Sink&, std::size_t )
+         */
+        void generate( const Generator::Sink& sink, std::size_t chunkSize = 1 << 16 ) const
+        {
+            m_generator.generate( *m_re, sink, chunkSize );
+        }
+
+        /**
+         * seeds the generator of this copy of the pattern
+         */
+        void seed( std::uint64_t seed )
+        {
+            m_generator.seed( seed );
+        }
+
+        const std::string& regex() const { return m_regex; }
+
+        const Re& re() const { return *m_re; }
+
+        const Generator& generator() const { return m_generator; }
+
+        /** @return static analysis of the regex for the generator's settings */
+        const Analysis& analysis() const { return *m_analysis; }
+
+        /** @return shape of the regex, which tells how the strings are generated */
+        const Shape& shape() const { return *m_shape; }
+
+        /**
+         * @return the negated or restricted sets of the regex resolved with the generator's settings, by node,
+         *         along with those of the other patterns of its library
+         */
+        const Generator::ResolvedSets& resolvedSets() const { return *m_sets; }
+
+    private:
+        static std::shared_ptr<const Re> parse( const std::string& regex )
+        {
+            auto tokens = lexer( regex );
+            return std::make_shared<const Re>( Parser().parse( tokens ) );
+        }
+
+        /** largest number of bytes reserved upfront for a string */
+        static const std::size_t s_maxReserve = 1 << 20;
+
+        std::string m_regex;
+        std::shared_ptr<const Re> m_re;
+        Generator m_generator;
+        std::shared_ptr<const Analysis> m_analysis;
+        std::shared_ptr<const Shape> m_shape;
+
+        /** sets of the regex resolved once with the settings of the generator, shared by the patterns of a library */
+        std::shared_ptr<const Generator::ResolvedSets> m_sets;
+
+        /** number of bytes reserved for each generated string */
+        std::size_t m_reserve;
+    };
+}
\ No newline at end of file
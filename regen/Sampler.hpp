@@ -0,0 +1,396 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <memory>
+#include <new>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/seed_seq.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include "Automaton.hpp"
+
+namespace regen
+{
+    /**
+     * Generates strings uniformly among the strings of a language with a bounded length
+     * 
+     * The language is given as a DFA, e.g. the strings matching a regex and not another one.
+     * The number of accepted strings of each length from each state is counted once, then each
+     * string is drawn byte by byte following these counts: no string is ever rejected.
+     * 
+     * Lengths are in bytes of the UTF-8 encoded strings.
+     * 
+     * A sampler is seeded from the generator it is built from, so a seeded generator gives reproducible strings.
+     * A sampler is not thread safe, its completions can be used by other threads than the sampler's.
+     * Copies of a sampler and its completions share its counts, which are immutable.
+     */
+    class LanguageSampler
+    {
+        /** counts shared by a sampler, its copies and its completions */
+        class Language;
+
+    public:
+        /**
+         * Completions of a prefix: the strings of the language starting with the prefix
+         * 
+         * The prefix is matched once when the completion is built, each generated string
+         * only costs its remaining bytes. A completion keeps the counts of its sampler alive.
+         * 
+         * A completion has its own random number generator, seeded by the sampler: it is not thread safe,
+         * but completions of the same sampler can be used by different threads.
+         * 
+         * @see LanguageSampler::complete
+         */
+        class Completion
+        {
+        public:
+            /**
+             * @return a string picked uniformly among the strings of the language starting with the prefix
+             *         (the prefix included)
+             */
+            std::string generate() const
+            {
+                std::string res;
+                res.reserve( m_prefix.size() + m_maxLength );
+                res += m_prefix;
+                m_language->sample( m_state, m_minLength, m_maxLength, m_rng, res );
+                return res;
+            }
+
+            /**
+             * seeds the random number generator of the completion
+             */
+            void seed( std::uint64_t seed )
+            {
+                boost::random::seed_seq seq{ static_cast<std::uint32_t>( seed ), static_cast<std::uint32_t>( seed >> 32 ) };
+                m_rng.seed( seq );
+            }
+
+            /**
+             * @return number of strings of the language starting with the prefix (may be rounded)
+             */
+            long double count() const
+            {
+                return m_language->total( m_state, m_minLength, m_maxLength );
+            }
+
+            const std::string& prefix() const { return m_prefix; }
+
+        private:
+            friend class LanguageSampler;
+
+            Completion( const LanguageSampler& sampler, boost::string_view prefix, std::int32_t state,
+                        std::size_t minLength, std::size_t maxLength )
+            : m_language( sampler.m_language ),
+            m_rng( sampler.m_rng() ),
+            m_prefix( prefix.data(), prefix.size() ),
+            m_state( state ),
+            m_minLength( minLength ),
+            m_maxLength( maxLength )
+            {
+            }
+
+            std::shared_ptr<const Language> m_language;
+
+            mutable boost::random::mt19937 m_rng;
+
+            std::string m_prefix;
+
+            /** state reached after the prefix */
+            std::int32_t m_state;
+
+            /** bounds on the length of the completions, without the prefix */
+            std::size_t m_minLength;
+            std::size_t m_maxLength;
+        };
+
+        /**
+         * strings the generator could produce for re, with its characters and its bounds on the repetitions
+         * 
+         * Unlike Generator::generate, the strings are picked uniformly among all these strings
+         * up to the maximum length, so longer strings are more likely. This is mostly useful to complete prefixes.
+         * 
+         * @param re regex the strings are generated from
+         * @param maxLength maximum length of the strings
+         * @param generator settings restricting the characters of the strings
+         * @param minLength minimum length of the strings
+         * 
+         * @throw std::runtime_error no string of the requested lengths is in the language
+         */
+        static LanguageSampler matching( const Re& re,
+                                            std::size_t maxLength,
+                                            const Generator& generator = Generator(),
+                                            std::size_t minLength = 0 )
+        {
+            return LanguageSampler( Dfa( Nfa::generated( re, generator ) ), minLength, maxLength, generator );
+        }
+
+        /**
+         * strings the generator could produce for re, with its characters and its bounds on the repetitions,
+         * which do not match excluded
+         * 
+         * @param re regex the strings are generated from
+         * @param excluded regex the strings must not match
+         * @param maxLength maximum length of the strings
+         * @param generator settings restricting the characters of the strings
+         * @param minLength minimum length of the strings
+         * 
+         * @throw std::runtime_error no string of the requested lengths is in the language
+         */
+        static LanguageSampler difference( const Re& re, const Re& excluded,
+                                            std::size_t maxLength,
+                                            const Generator& generator = Generator(),
+                                            std::size_t minLength = 0 )
+        {
+            const Nfa nfa = Nfa::generated( re, generator );
+            const Nfa excludedNfa = Nfa::regex( excluded );
+            return LanguageSampler( Dfa( nfa, &excludedNfa ), minLength, maxLength, generator );
+        }
+
+        /**
+         * strings made of the characters the generator produces for '.' which do not match re,
+         * e.g. near miss negative samples
+         * 
+         * @param re regex the strings must not match
+         * @param maxLength maximum length of the strings
+         * @param generator settings restricting the characters of the strings
+         * @param minLength minimum length of the strings
+         * 
+         * @throw std::runtime_error no string of the requested lengths is in the language
+         */
+        static LanguageSampler complement( const Re& re,
+                                            std::size_t maxLength,
+                                            const Generator& generator = Generator(),
+                                            std::size_t minLength = 0 )
+        {
+            auto tokens = lexer( ".*" );
+            const Nfa universe = Nfa::generated( Parser().parse( tokens ), generator, false );
+            const Nfa excludedNfa = Nfa::regex( re );
+            return LanguageSampler( Dfa( universe, &excludedNfa ), minLength, maxLength, generator );
+        }
+
+        /**
+         * @return a string picked uniformly among the strings of the language
+         */
+        std::string generate() const
+        {
+            std::string res;
+            m_language->sample( Dfa::s_start, m_language->minLength, m_language->maxLength, m_rng, res );
+            return res;
+        }
+
+        /**
+         * seeds the random number generator of the sampler, the completions built afterwards are seeded from it
+         * 
+         * @param seed seed of the random number generator
+         */
+        void seed( std::uint64_t seed )
+        {
+            boost::random::seed_seq seq{ static_cast<std::uint32_t>( seed ), static_cast<std::uint32_t>( seed >> 32 ) };
+            m_rng.seed( seq );
+        }
+
+        /**
+         * @return number of strings in the language (may be rounded)
+         */
+        long double count() const
+        {
+            return m_language->total( Dfa::s_start, m_language->minLength, m_language->maxLength );
+        }
+
+        /**
+         * matches a prefix, the completion then generates the strings of the language starting with it
+         * 
+         * @param prefix beginning of the strings (UTF-8 encoded)
+         * 
+         * @throw std::runtime_error no string of the language starts with the prefix
+         * 
+         * @return the completions of the prefix, to generate as many strings as needed
+         */
+        Completion complete( boost::string_view prefix ) const
+        {
+            const Language& language = *m_language;
+            std::int32_t state = Dfa::s_start;
+            for( std::size_t i = 0; i < prefix.size() && state != Dfa::s_dead; ++i )
+                state = language.dfa.next( state, static_cast<unsigned char>( prefix[i] ) );
+
+            if( state == Dfa::s_dead || prefix.size() > language.maxLength )
+                throw std::runtime_error( "no string of the language starts with the prefix" );
+
+            const std::size_t minLength = prefix.size() < language.minLength ? language.minLength - prefix.size() : 0;
+            const std::size_t maxLength = language.maxLength - prefix.size();
+            if( language.total( state, minLength, maxLength ) == 0 )
+                throw std::runtime_error( "no string of the language starts with the prefix" );
+
+            return Completion( *this, prefix, state, minLength, maxLength );
+        }
+
+    private:
+        /**
+         * the DFA of the language and the number of its strings of each length from each state
+         */
+        class Language
+        {
+        public:
+            Language( Dfa&& dfa, std::size_t minLength, std::size_t maxLength )
+            : dfa( std::move( dfa ) ),
+            minLength( minLength ),
+            maxLength( maxLength )
+            {
+                if( minLength > maxLength )
+                    throw std::logic_error( "minimum length cannot be greater than maximum length" );
+
+                const std::size_t states = this->dfa.size();
+                if( maxLength >= m_counts.max_size() / states )
+                    throw std::runtime_error( "too many strings to count, lower the maximum length" );
+                try
+                {
+                    m_counts.assign( ( maxLength + 1 ) * states, 0 );
+                }
+                catch( std::bad_alloc& )
+                {
+                    throw std::runtime_error( "not enough memory to count the strings, lower the maximum length" );
+                }
+
+                for( std::size_t s = 1; s < states; ++s )
+                    m_counts[s] = this->dfa.accepting( s ) ? 1 : 0;
+
+                for( std::size_t r = 1; r <= maxLength; ++r )
+                {
+                    for( std::size_t s = 1; s < states; ++s )
+                    {
+                        long double n = 0;
+                        for( std::size_t c = 0; c < this->dfa.classCount(); ++c )
+                            n += classSize( c ) * counts( this->dfa.nextByClass( s, c ), r - 1 );
+                        m_counts[r * states + s] = n;
+                    }
+                }
+
+                const long double n = total( Dfa::s_start, minLength, maxLength );
+                if( std::isinf( n ) )
+                    throw std::runtime_error( "too many strings to sample from, lower the maximum length" );
+                if( n == 0 )
+                    throw std::runtime_error( "no string of the requested length is in the language" );
+            }
+
+            /** @return number of accepted strings of exactly r bytes from a state */
+            long double counts( std::int32_t state, std::size_t r ) const
+            {
+                return m_counts[r * dfa.size() + state];
+            }
+
+            long double total( std::int32_t state, std::size_t minLength, std::size_t maxLength ) const
+            {
+                long double n = 0;
+                for( std::size_t r = minLength; r <= maxLength; ++r )
+                    n += counts( state, r );
+                return n;
+            }
+
+            std::size_t classSize( std::size_t c ) const
+            {
+                return dfa.byteClass( c ).second - dfa.byteClass( c ).first + 1;
+            }
+
+            /**
+             * appends a string picked uniformly among the accepted strings from a state
+             * with a length in [minLength, maxLength]
+             */
+            void sample( std::int32_t state, std::size_t minLength, std::size_t maxLength,
+                            boost::random::mt19937& rng, std::string& out ) const
+            {
+                // pick the length, then the bytes one by one
+                boost::random::uniform_real_distribution<long double> length_dice( 0, total( state, minLength, maxLength ) );
+                long double x = length_dice( rng );
+                std::size_t length = maxLength;
+                for( std::size_t r = minLength; r <= maxLength; ++r )
+                {
+                    if( counts( state, r ) == 0 )
+                        continue;
+                    length = r;
+                    if( x < counts( state, r ) )
+                        break;
+                    x -= counts( state, r );
+                }
+
+                for( std::size_t r = length; r > 0; --r )
+                {
+                    boost::random::uniform_real_distribution<long double> class_dice( 0, counts( state, r ) );
+                    x = class_dice( rng );
+
+                    std::size_t cls = dfa.classCount();
+                    for( std::size_t c = 0; c < dfa.classCount(); ++c )
+                    {
+                        const long double n = classSize( c ) * counts( dfa.nextByClass( state, c ), r - 1 );
+                        if( n == 0 )
+                            continue;
+                        cls = c;
+                        if( x < n )
+                            break;
+                        x -= n;
+                    }
+
+                    boost::random::uniform_int_distribution<int> byte_dice( dfa.byteClass( cls ).first, dfa.byteClass( cls ).second );
+                    out += static_cast<char>( byte_dice( rng ) );
+                    state = dfa.nextByClass( state, cls );
+                }
+            }
+
+            const Dfa dfa;
+
+            /** bounds on the length of the strings of the language */
+            const std::size_t minLength;
+            const std::size_t maxLength;
+
+        private:
+            /** m_counts[r * dfa.size() + state]: number of accepted strings of exactly r bytes from state */
+            std::vector<long double> m_counts;
+        };
+
+        /**
+         * @throw std::runtime_error the strings cannot be counted or there is none of the requested lengths
+         */
+        LanguageSampler( Dfa&& dfa, std::size_t minLength, std::size_t maxLength, const Generator& generator )
+        : m_language( std::make_shared<const Language>( std::move( dfa ), minLength, maxLength ) )
+        {
+            // drawn from the generator, so that a seeded generator gives the same strings
+            const std::uint32_t seed[2] = { generator.m_rng(), generator.m_rng() };
+            boost::random::seed_seq seq( seed, seed + 2 );
+            m_rng.seed( seq );
+        }
+
+        /** random number generator */
+        mutable boost::random::mt19937 m_rng;
+
+        std::shared_ptr<const Language> m_language;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,368 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "Generator.hpp"
+
+namespace regen
+{
+    /**
+     * Shape of a regex, for which strings can be generated without walking the ast
+     * 
+     * - LITERAL: a single string, e.g. "abc" or "(ab){3}"
+     * - FIXED_SEQUENCE: a fixed number of characters, each picked in a set, e.g. "[A-Z]{3}[0-9]{6}"
+     * - LITERAL_ALTERNATION: a choice between literals, e.g. "111|222|333"
+     * - SINGLE_SET: a set, a char or '.' with a quantifier, e.g. "[a-z]+"
+     * - GENERAL: anything else, generated by the Generator
+     * 
+     * The specialized generation makes the same random draws as the Generator,
+     * so a seeded pattern generates the same strings whatever its shape.
+     */
+    class Shape
+    {
+    public:
+        enum EKind
+        {
+            LITERAL,
+            FIXED_SEQUENCE,
+            LITERAL_ALTERNATION,
+            SINGLE_SET,
+            GENERAL
+        };
+
+        /**
+         * classifies a regex
+         * 
+         * @param re regular expression ast (@see regen::Parser to create it)
+         * @param generator generator whose settings the shape is computed for
+         */
+        Shape( const Re& re, const Generator& generator )
+        : m_kind( GENERAL ),
+        m_min( 0 ),
+        m_max( 0 )
+        {
+            if( re.size() > 1 )
+                classifyAlternation( re, generator );
+            else if( !classifySingleSet( re, generator ) )
+                classifySequence( re, generator );
+        }
+
+        EKind kind() const { return m_kind; }
+
+        /** @return name of the shape, e.g. for logs */
+        const char* name() const
+        {
+            switch( m_kind )
+            {
+            case LITERAL:               return "literal";
+            case FIXED_SEQUENCE:        return "fixed sequence";
+            case LITERAL_ALTERNATION:   return "literal alternation";
+            case SINGLE_SET:            return "single set";
+            case GENERAL:               break;
+            }
+            return "general";
+        }
+
+        /**
+         * appends a random string of this shape
+         * 
+         * @param rng random number generator of the Generator the shape was computed for
+         * @param out string the generated string is appended to (UTF-8 encoded)
+         * 
+         * @throw std::logic_error the shape is GENERAL
+         */
+        template<class Engine>
+        void generate( Engine& rng, std::string& out ) const
+        {
+            switch( m_kind )
+            {
+            case LITERAL:
+                out += m_literals;
+                return;
+            case FIXED_SEQUENCE:
+                for( const Run& run : m_runs )
+                    pick( m_sets[run.set], run.count, rng, out );
+                return;
+            case LITERAL_ALTERNATION:
+            {
+                boost::random::uniform_int_distribution<> union_dice( 0, m_alternatives->size() - 1 );
+                const boost::string_view literal = (*m_alternatives)[union_dice( rng )];
+                out.append( literal.data(), literal.size() );
+                return;
+            }
+            case SINGLE_SET:
+            {
+                boost::random::uniform_int_distribution<> iter_dice( m_min, m_max );
+                pick( m_sets.front(), iter_dice( rng ), rng, out );
+                return;
+            }
+            case GENERAL:
+                break;
+            }
+            throw std::logic_error( "a general regex must be generated by the Generator" );
+        }
+
+    private:
+        /** count characters picked in the same set */
+        struct Run
+        {
+            std::uint32_t set;
+            std::size_t count;
+        };
+
+        /** largest number of runs of a fixed sequence, larger ones are generated by the Generator */
+        enum : std::size_t
+        {
+            s_maxRuns = 1 << 12,
+            s_maxLiteral = 1 << 20
+        };
+
+        template<class Engine>
+        static void pick( const CharSet& set, std::size_t count, Engine& rng, std::string& out )
+        {
+            if( set.size() == 1 )
+            {
+                const std::string c = toUtf8( set[0] );
+                for( std::size_t i = 0; i < count; ++i )
+                    out += c;
+                return;
+            }
+
+            boost::random::uniform_int_distribution<std::size_t> choice_dice( 0, set.size() - 1 );
+            if( set.intervals().back().last < 0x80 )
+            {
+                // ascii: one byte per character
+                const std::size_t begin = out.size();
+                out.resize( begin + count );
+                for( std::size_t i = 0; i < count; ++i )
+                    out[begin + i] = static_cast<char>( set[choice_dice( rng )] );
+                return;
+            }
+
+            for( std::size_t i = 0; i < count; ++i )
+                appendUtf8( out, set[choice_dice( rng )] );
+        }
+
+        /**
+         * characters an elementary regex generates, when it is a single character
+         * 
+         * @return false if it is a group or a dictionary reference
+         */
+        static bool elementSet( const ElementaryRe& ere, const Generator& generator, CharSet& set )
+        {
+            if( auto ptr = dynamic_cast<const Char*>( &ere ) )
+                set = CharSet( ptr->c, ptr->c );
+            else if( auto ptr = dynamic_cast<const Set*>( &ere ) )
+                set = generator.resolve( *ptr );
+            else if( auto ptr = dynamic_cast<const Any*>( &ere ) )
+                set = generator.resolve( *ptr );
+            else
+                return false;
+            return true;
+        }
+
+        /**
+         * appends the runs of a concatenation if it generates a fixed number of characters
+         * 
+         * @return false if it does not
+         */
+        bool flatten( const SimpleRe& sre, const Generator& generator, std::vector<Run>& runs )
+        {
+            for( const BasicRe& bre : sre.concatRes )
+            {
+                const ElementaryRe* ere = dynamic_cast<const ElementaryRe*>( bre.sub.get() );
+                std::size_t count = 1;
+                if( !ere )
+                {
+                    const auto bounds = generator.repetitionBounds( *bre.sub );
+                    if( bounds.first != bounds.second )
+                        return false;
+                    count = bounds.first;
+                    ere = quantified( *bre.sub );
+                }
+
+                if( count == 0 )
+                    continue;
+
+                CharSet set;
+                if( elementSet( *ere, generator, set ) )
+                {
+                    if( set.empty() )
+                        return false;
+                    addRun( set, count, runs );
+                }
+                else if( auto ptr = dynamic_cast<const Group*>( ere ) )
+                {
+                    // group without alternative: its runs repeated count times
+                    const Re& group = ptr->re;
+                    std::vector<Run> groupRuns;
+                    if( group.size() != 1 || !flatten( group.unionRes().front(), generator, groupRuns ) )
+                        return false;
+                    if( groupRuns.size() * count > s_maxRuns )
+                        return false;
+                    for( std::size_t i = 0; i < count; ++i )
+                        for( const Run& run : groupRuns )
+                            addRun( m_sets[run.set], run.count, runs );
+                }
+                else
+                {
+                    // a dictionary reference
+                    return false;
+                }
+
+                if( runs.size() > s_maxRuns )
+                    return false;
+            }
+
+            return true;
+        }
+
+        void addRun( const CharSet& set, std::size_t count, std::vector<Run>& runs )
+        {
+            std::uint32_t index = 0;
+            while( index < m_sets.size() && m_sets[index] != set )
+                ++index;
+            if( index == m_sets.size() )
+                m_sets.push_back( set );
+
+            if( !runs.empty() && runs.back().set == index )
+                runs.back().count += count;
+            else
+                runs.push_back( Run{ index, count } );
+        }
+
+        /**
+         * @return the literal of a run list, false if a run has several characters or it is too long
+         */
+        bool literal( const std::vector<Run>& runs, std::string& out ) const
+        {
+            for( const Run& run : runs )
+            {
+                const CharSet& set = m_sets[run.set];
+                if( set.size() != 1 || out.size() + run.count * utf8Length( set[0] ) > s_maxLiteral )
+                    return false;
+                const std::string c = toUtf8( set[0] );
+                for( std::size_t i = 0; i < run.count; ++i )
+                    out += c;
+            }
+            return true;
+        }
+
+        void classifySequence( const Re& re, const Generator& generator )
+        {
+            if( !flatten( re.unionRes().front(), generator, m_runs ) )
+                return reset();
+
+            if( literal( m_runs, m_literals ) )
+            {
+                m_kind = LITERAL;
+                m_runs.clear();
+                m_sets.clear();
+            }
+            else
+            {
+                m_kind = FIXED_SEQUENCE;
+                m_literals.clear();
+            }
+        }
+
+        void classifyAlternation( const Re& re, const Generator& generator )
+        {
+            m_kind = LITERAL_ALTERNATION;
+
+            // packed by the parser: shared as is
+            if( re.literals )
+            {
+                m_alternatives = re.literals;
+                return;
+            }
+
+            auto alternatives = std::make_shared<Literals>();
+            for( const SimpleRe& sre : re.unionRes() )
+            {
+                std::vector<Run> runs;
+                std::string str;
+                if( !flatten( sre, generator, runs ) || !literal( runs, str ) )
+                    return reset();
+                alternatives->push_back( str );
+            }
+            m_alternatives = std::move( alternatives );
+            m_sets.clear();
+        }
+
+        bool classifySingleSet( const Re& re, const Generator& generator )
+        {
+            const SimpleRe& sre = re.unionRes().front();
+            if( sre.concatRes.size() != 1 || dynamic_cast<const ElementaryRe*>( sre.concatRes.front().sub.get() ) )
+                return false;
+
+            const BasicReSub& quantifier = *sre.concatRes.front().sub;
+            const auto bounds = generator.repetitionBounds( quantifier );
+            CharSet set;
+            if( bounds.first == bounds.second || !elementSet( *quantified( quantifier ), generator, set ) || set.empty() )
+                return false;
+
+            m_sets.push_back( set );
+            m_min = bounds.first;
+            m_max = bounds.second;
+            m_kind = SINGLE_SET;
+            return true;
+        }
+
+        void reset()
+        {
+            m_kind = GENERAL;
+            m_literals.clear();
+            m_alternatives.reset();
+            m_runs.clear();
+            m_sets.clear();
+        }
+
+        EKind m_kind;
+
+        /** LITERAL: the string */
+        std::string m_literals;
+
+        /** LITERAL_ALTERNATION: the packed alternatives, shared with the ast when the parser packed them */
+        std::shared_ptr<const Literals> m_alternatives;
+
+        /** FIXED_SEQUENCE: the runs of characters */
+        std::vector<Run> m_runs;
+
+        /** distinct sets of the runs, SINGLE_SET: the set */
+        std::vector<CharSet> m_sets;
+
+        /** SINGLE_SET: bounds of the repetition */
+        std::size_t m_min;
+        std::size_t m_max;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,355 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include <boost/lockfree/queue.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include "Pattern.hpp"
+
+namespace regen
+{
+    /**
+     * Continuous feed of strings generated in the background
+     * 
+     * Producer threads generate slabs of strings packed in a single buffer and push them
+     * to a bounded lock-free queue; consumers pop the strings one by one from the slabs.
+     * When the queue is full the producers wait for consumers to give slabs back, so the
+     * memory used is bounded by the capacity of the queue. Waiting threads sleep on a condition
+     * variable, which is only signaled when a thread waits.
+     * 
+     * If a producer fails, the stream stops and its exception is rethrown to the consumers
+     * once they have read the strings generated before.
+     * 
+     * Each consumer thread reads through its own SampleStream::Consumer.
+     */
+    class SampleStream
+    {
+    private:
+        /** strings packed in a single buffer */
+        struct Slab
+        {
+            std::string data;
+
+            /** end of each string in data */
+            std::vector<std::size_t> ends;
+        };
+
+    public:
+        struct Stats
+        {
+            /** slabs ready to be consumed */
+            std::size_t occupancy;
+
+            /** strings generated */
+            std::uint64_t produced;
+
+            /** strings consumed */
+            std::uint64_t consumed;
+
+            /** number of times a producer waited because the queue was full */
+            std::uint64_t producerStalls;
+
+            /** number of times a consumer waited because the queue was empty */
+            std::uint64_t consumerStalls;
+        };
+
+        /**
+         * Reads strings from the stream, one per consumer thread
+         */
+        class Consumer
+        {
+        public:
+            explicit Consumer( SampleStream& stream ) : m_stream( &stream ) {}
+
+            Consumer( Consumer&& other ) : m_stream( other.m_stream ), m_slab( other.m_slab ), m_next( other.m_next )
+            {
+                other.m_slab = nullptr;
+            }
+
+            Consumer( const Consumer& ) = delete;
+            Consumer& operator=( const Consumer& ) = delete;
+
+            ~Consumer()
+            {
+                if( m_slab )
+                    m_stream->recycle( m_slab );
+            }
+
+            /**
+             * reads the next string, waiting for one if none is ready
+             * 
+             * @param sample set to the string, valid until the next call to pop
+             * 
+             * @return false if the stream is stopped and no string is left
+             * 
+             * @throw the exception of a failed producer, once no string is left
+             */
+            bool pop( boost::string_view& sample )
+            {
+                if( !m_slab || m_next == m_slab->ends.size() )
+                {
+                    if( m_slab )
+                        m_stream->recycle( m_slab );
+                    m_slab = nullptr;
+                    m_slab = m_stream->next();
+                    m_next = 0;
+                    if( !m_slab )
+                        return false;
+                }
+
+                const std::size_t begin = m_next == 0 ? 0 : m_slab->ends[m_next-1];
+                sample = boost::string_view( m_slab->data.data() + begin, m_slab->ends[m_next] - begin );
+                ++m_next;
+                m_stream->m_consumed.fetch_add( 1, std::memory_order_relaxed );
+                return true;
+            }
+
+        private:
+            SampleStream* m_stream;
+            Slab* m_slab = nullptr;
+            std::size_t m_next = 0;
+        };
+
+        /**
+         * starts the producers
+         * 
+         * @param pattern pattern to generate strings from
+         * @param producers number of producer threads
+         * @param slabSize number of strings per slab
+         * @param capacity number of slabs, bounds the memory used
+         */
+        explicit SampleStream( const Pattern& pattern,
+                                std::size_t producers = 1,
+                                std::size_t slabSize = 1024,
+                                std::size_t capacity = 64 )
+        : m_slabSize( slabSize ),
+        m_ready( capacity ),
+        m_free( capacity )
+        {
+            if( producers < 1 || slabSize < 1 || capacity < 1 )
+                throw std::logic_error( "a stream needs at least one producer, one string per slab and one slab" );
+
+            for( std::size_t i = 0; i < capacity; ++i )
+            {
+                m_slabs.push_back( std::make_unique<Slab>() );
+                m_free.push( m_slabs.back().get() );
+            }
+
+            const std::uint64_t seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+            for( std::size_t i = 0; i < producers; ++i )
+            {
+                Pattern copy = pattern;
+                copy.seed( seed + i );
+                m_producers.emplace_back( [this, copy]() { produce( copy ); } );
+            }
+        }
+
+        SampleStream( const SampleStream& ) = delete;
+        SampleStream& operator=( const SampleStream& ) = delete;
+
+        /**
+         * stops the producers, consumers must be destroyed before the stream
+         */
+        ~SampleStream()
+        {
+            stop();
+        }
+
+        /**
+         * stops the producers, consumers can still read the strings already generated
+         */
+        void stop()
+        {
+            halt();
+            for( std::thread& t : m_producers )
+            {
+                if( t.joinable() )
+                    t.join();
+            }
+        }
+
+        /**
+         * @return a new consumer, to be used by a single thread
+         */
+        Consumer consumer()
+        {
+            return Consumer( *this );
+        }
+
+        Stats stats() const
+        {
+            return Stats{ m_occupancy.load(), m_produced.load(), m_consumed.load(),
+                            m_producerStalls.load(), m_consumerStalls.load() };
+        }
+
+    private:
+        typedef boost::lockfree::queue<Slab*, boost::lockfree::fixed_sized<true>> Queue;
+
+        void produce( const Pattern& pattern )
+        {
+            Slab* slab = nullptr;
+            try
+            {
+                while( !m_stop && pop( m_free, slab, m_freeChanged, m_freeWaiters, m_producerStalls ) )
+                {
+                    slab->data.clear();
+                    slab->ends.clear();
+                    for( std::size_t i = 0; i < m_slabSize; ++i )
+                    {
+                        pattern.generate( slab->data );
+                        slab->ends.push_back( slab->data.size() );
+                    }
+
+                    m_produced.fetch_add( m_slabSize, std::memory_order_relaxed );
+                    m_occupancy.fetch_add( 1 );
+                    push( m_ready, slab, m_readyChanged, m_readyWaiters );
+                    slab = nullptr;
+                }
+            }
+            catch( ... )
+            {
+                if( slab )
+                    m_free.push( slab );
+                {
+                    std::lock_guard<std::mutex> lock( m_mutex );
+                    if( !m_error )
+                        m_error = std::current_exception();
+                }
+                halt();
+            }
+        }
+
+        /**
+         * @return the next slab ready to be consumed, nullptr if the stream is stopped
+         * 
+         * @throw the exception of a failed producer, once no slab is left
+         */
+        Slab* next()
+        {
+            Slab* slab;
+            if( !pop( m_ready, slab, m_readyChanged, m_readyWaiters, m_consumerStalls ) )
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                if( m_error )
+                    std::rethrow_exception( m_error );
+                return nullptr;
+            }
+
+            m_occupancy.fetch_sub( 1 );
+            return slab;
+        }
+
+        void recycle( Slab* slab )
+        {
+            push( m_free, slab, m_freeChanged, m_freeWaiters );
+        }
+
+        /**
+         * pops a slab from a queue, sleeping while the queue is empty
+         * 
+         * @return false if the stream is stopped and the queue is empty
+         */
+        bool pop( Queue& queue, Slab*& slab, std::condition_variable& changed,
+                    std::atomic<std::size_t>& waiters, std::atomic<std::uint64_t>& stalls )
+        {
+            if( queue.pop( slab ) )
+                return true;
+
+            stalls.fetch_add( 1, std::memory_order_relaxed );
+            std::unique_lock<std::mutex> lock( m_mutex );
+            waiters.fetch_add( 1 );
+            // pairs with the fence of push: either the pusher sees the waiter, or the waiter sees the slab
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            bool popped = false;
+            changed.wait( lock, [&]() { return ( popped = queue.pop( slab ) ) || m_stop; } );
+            waiters.fetch_sub( 1 );
+            return popped;
+        }
+
+        /**
+         * pushes a slab to a queue, waking a thread up if one waits for it
+         */
+        void push( Queue& queue, Slab* slab, std::condition_variable& changed, std::atomic<std::size_t>& waiters )
+        {
+            queue.push( slab );
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            if( waiters.load() > 0 )
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                changed.notify_one();
+            }
+        }
+
+        /**
+         * stops the producers and wakes every waiting thread up, without joining the producers
+         */
+        void halt()
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+            m_readyChanged.notify_all();
+            m_freeChanged.notify_all();
+        }
+
+        std::size_t m_slabSize;
+
+        std::vector<std::unique_ptr<Slab>> m_slabs;
+
+        /** slabs ready to be consumed */
+        Queue m_ready;
+
+        /** slabs to be filled by the producers */
+        Queue m_free;
+
+        std::vector<std::thread> m_producers;
+        std::atomic<bool> m_stop{ false };
+
+        /** guards the sleeps of the threads waiting on a queue, and m_error */
+        std::mutex m_mutex;
+        std::condition_variable m_readyChanged;
+        std::condition_variable m_freeChanged;
+        std::atomic<std::size_t> m_readyWaiters{ 0 };
+        std::atomic<std::size_t> m_freeWaiters{ 0 };
+
+        /** exception of the first producer which failed */
+        std::exception_ptr m_error;
+
+        std::atomic<std::size_t> m_occupancy{ 0 };
+        std::atomic<std::uint64_t> m_produced{ 0 };
+        std::atomic<std::uint64_t> m_consumed{ 0 };
+        std::atomic<std::uint64_t> m_producerStalls{ 0 };
+        std::atomic<std::uint64_t> m_consumerStalls{ 0 };
+    };
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+
+namespace regen
+{
+    /**
+     * Fixed number of threads running the tasks submitted to them, with work stealing
+     * 
+     * Each thread has its own queue of tasks: the tasks submitted by a thread of the pool go
+     * to its own queue, the others are spread over the queues. A thread runs the last task
+     * of its queue and, once it is empty, steals the first task of another queue, so that
+     * no thread stays idle while tasks of very different costs are waiting elsewhere.
+     * 
+     * Tasks must not wait for other tasks of the same pool, as all the threads
+     * could end up waiting.
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * @param threads number of threads, defaults to the number of cores
+         */
+        explicit ThreadPool( std::size_t threads = std::thread::hardware_concurrency() )
+        : m_next( 0 ),
+        m_steals( 0 ),
+        m_pending( 0 ),
+        m_stopping( false )
+        {
+            threads = std::max<std::size_t>( threads, 1 );
+            for( std::size_t i = 0; i < threads; ++i )
+                m_queues.emplace_back( new Queue );
+
+            m_threads.reserve( threads );
+            for( std::size_t i = 0; i < threads; ++i )
+                m_threads.emplace_back( [this, i]{ run( i ); } );
+        }
+
+        ThreadPool( const ThreadPool& ) = delete;
+        ThreadPool& operator=( const ThreadPool& ) = delete;
+
+        /**
+         * runs the remaining tasks then joins the threads
+         */
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_stopping = true;
+            }
+            m_ready.notify_all();
+            for( std::thread& thread : m_threads )
+                thread.join();
+        }
+
+        /**
+         * queues a task
+         * 
+         * @return future of the task, get() rethrows its exception if it threw one
+         */
+        template<class F>
+        std::future<void> submit( F&& task )
+        {
+            std::packaged_task<void()> packaged( std::forward<F>( task ) );
+            std::future<void> res = packaged.get_future();
+
+            const Current& current = Current::get();
+            const std::size_t i = current.pool == this ? current.index
+                                                       : m_next.fetch_add( 1, std::memory_order_relaxed ) % m_queues.size();
+            {
+                std::lock_guard<std::mutex> lock( m_queues[i]->mutex );
+                m_queues[i]->tasks.push_back( std::move( packaged ) );
+            }
+            {
+                // under the mutex, so that a thread going to sleep sees the task or is woken up
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_pending.fetch_add( 1 );
+            }
+            m_ready.notify_one();
+            return res;
+        }
+
+        /** @return number of threads */
+        std::size_t size() const { return m_threads.size(); }
+
+        /** @return number of tasks a thread took from the queue of another one */
+        std::uint64_t steals() const { return m_steals.load( std::memory_order_relaxed ); }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::packaged_task<void()>> tasks;
+        };
+
+        /** pool and queue of the running thread */
+        struct Current
+        {
+            const ThreadPool* pool;
+            std::size_t index;
+
+            static Current& get()
+            {
+                static thread_local Current current{ nullptr, 0 };
+                return current;
+            }
+        };
+
+        void run( std::size_t index )
+        {
+            Current::get() = Current{ this, index };
+
+            for( ;; )
+            {
+                std::packaged_task<void()> task;
+                if( pop( index, task ) )
+                {
+                    task();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock( m_mutex );
+                m_ready.wait( lock, [this]{ return m_stopping || m_pending.load() > 0; } );
+                if( m_pending.load() <= 0 )
+                    return;
+            }
+        }
+
+        /**
+         * takes the last task of the thread's own queue, or the first task of another queue,
+         * only locking the queue it looks at
+         */
+        bool pop( std::size_t index, std::packaged_task<void()>& task )
+        {
+            for( std::size_t n = 0; n < m_queues.size(); ++n )
+            {
+                Queue& queue = *m_queues[( index + n ) % m_queues.size()];
+                {
+                    std::lock_guard<std::mutex> lock( queue.mutex );
+                    if( queue.tasks.empty() )
+                        continue;
+                    if( n == 0 )
+                    {
+                        task = std::move( queue.tasks.back() );
+                        queue.tasks.pop_back();
+                    }
+                    else
+                    {
+                        task = std::move( queue.tasks.front() );
+                        queue.tasks.pop_front();
+                        m_steals.fetch_add( 1, std::memory_order_relaxed );
+                    }
+                }
+
+                m_pending.fetch_sub( 1 );
+                return true;
+            }
+            return false;
+        }
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_threads;
+
+        /** queue of the next task submitted from outside the pool */
+        std::atomic<std::size_t> m_next;
+
+        std::atomic<std::uint64_t> m_steals;
+
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+
+        /**
+         * number of tasks in the queues, decremented without the mutex as it never wakes up a thread
+         * 
+         * signed: a task can be taken before its submission is counted
+         */
+        std::atomic<std::ptrdiff_t> m_pending;
+        bool m_stopping;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,333 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <cmath>
+#include <limits>
+
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include "Parser.hpp"
+
+namespace regen
+{
+    class Generator;
+
+    /**
+     * Walker alias table
+     * 
+     * picks an index with a probability proportional to its weight in O(1),
+     * using one uniform integer and one uniform real.
+     */
+    class AliasTable
+    {
+    public:
+        /**
+         * builds the table (Vose's method)
+         * 
+         * @param weights non negative weights, at least one of which is not zero
+         * 
+         * @throw std::runtime_error invalid weights
+         */
+        explicit AliasTable( const std::vector<double>& weights )
+        : m_probability( weights.size() ),
+        m_alias( weights.size() )
+        {
+            double total = 0;
+            for( double w : weights )
+            {
+                if( !( w >= 0 ) || std::isinf( w ) )
+                    throw std::runtime_error( "weights must be finite and non negative" );
+                total += w;
+            }
+            if( !( total > 0 ) )
+                throw std::runtime_error( "at least one weight must be greater than zero" );
+
+            const std::size_t n = weights.size();
+            std::vector<double> scaled( n );
+            std::vector<std::size_t> small, large;
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                scaled[i] = weights[i] * n / total;
+                ( scaled[i] < 1 ? small : large ).push_back( i );
+            }
+
+            while( !small.empty() && !large.empty() )
+            {
+                const std::size_t s = small.back();
+                small.pop_back();
+                const std::size_t l = large.back();
+
+                m_probability[s] = scaled[s];
+                m_alias[s] = l;
+
+                scaled[l] -= 1 - scaled[s];
+                if( scaled[l] < 1 )
+                {
+                    large.pop_back();
+                    small.push_back( l );
+                }
+            }
+
+            // what remains is 1 up to rounding errors
+            for( std::size_t i : large )
+            {
+                m_probability[i] = 1;
+                m_alias[i] = i;
+            }
+            for( std::size_t i : small )
+            {
+                m_probability[i] = 1;
+                m_alias[i] = i;
+            }
+        }
+
+        /**
+         * @return an index in [0, size()) picked proportionally to its weight
+         */
+        template<class Engine>
+        std::size_t operator()( Engine& rng ) const
+        {
+            boost::random::uniform_int_distribution<std::size_t> column_dice( 0, m_alias.size()-1 );
+            boost::random::uniform_real_distribution<double> coin( 0, 1 );
+
+            const std::size_t column = column_dice( rng );
+            return coin( rng ) < m_probability[column] ? column : m_alias[column];
+        }
+
+        std::size_t size() const { return m_alias.size(); }
+
+    private:
+        /** probability of keeping the column rather than taking its alias */
+        std::vector<double> m_probability;
+
+        std::vector<std::size_t> m_alias;
+    };
+
+    /**
+     * distribution of the number of repetitions of a quantifier
+     * 
+     * the distribution is truncated to the bounds of the quantifier.
+     */
+    class Distribution
+    {
+    public:
+        /** every number of repetitions is equally likely */
+        static Distribution uniform()
+        {
+            return Distribution( UNIFORM, 0 );
+        }
+
+        /**
+         * P(n) proportional to (1-p)^n
+         * 
+         * @param p probability of stopping after each repetition, in ]0, 1]
+         */
+        static Distribution geometric( double p )
+        {
+            if( !( p > 0 && p <= 1 ) )
+                throw std::runtime_error( "geometric distribution parameter must be in ]0, 1]" );
+            return Distribution( GEOMETRIC, p );
+        }
+
+        /**
+         * P(n) proportional to lambda^n / n!
+         * 
+         * @param lambda mean number of repetitions before truncation, greater than 0
+         */
+        static Distribution poisson( double lambda )
+        {
+            if( !( lambda > 0 ) || std::isinf( lambda ) )
+                throw std::runtime_error( "poisson distribution parameter must be greater than 0" );
+            return Distribution( POISSON, lambda );
+        }
+
+        /**
+         * P(n) proportional to weights[n], 0 past the end of weights
+         */
+        static Distribution table( const std::vector<double>& weights )
+        {
+            Distribution res( TABLE, 0 );
+            res.m_weights = weights;
+            return res;
+        }
+
+        /**
+         * @return the weights of n = min ... max
+         */
+        std::vector<double> weights( std::size_t min, std::size_t max ) const
+        {
+            std::vector<double> res( max - min + 1 );
+
+            if( m_type == POISSON )
+            {
+                // in log space, shifted by the largest term so that the exp does not underflow
+                double top = -std::numeric_limits<double>::infinity();
+                for( std::size_t n = min; n <= max; ++n )
+                {
+                    res[n-min] = n * std::log( m_parameter ) - std::lgamma( n + 1.0 );
+                    top = std::max( top, res[n-min] );
+                }
+                for( double& w : res )
+                    w = std::exp( w - top );
+            }
+            else
+            {
+                for( std::size_t n = min; n <= max; ++n )
+                {
+                    if( m_type == UNIFORM )
+                        res[n-min] = 1;
+                    else if( m_type == GEOMETRIC )
+                        res[n-min] = std::pow( 1 - m_parameter, static_cast<double>( n - min ) );
+                    else // TABLE
+                        res[n-min] = n < m_weights.size() ? m_weights[n] : 0;
+                }
+            }
+
+            return res;
+        }
+
+    private:
+        enum EType
+        {
+            UNIFORM,
+            GEOMETRIC,
+            POISSON,
+            TABLE
+        };
+
+        Distribution( EType type, double parameter ) : m_type( type ), m_parameter( parameter ) {}
+
+        EType m_type;
+        double m_parameter;
+        std::vector<double> m_weights;
+    };
+
+    /**
+     * Weights to skew the generation of a parsed regex
+     * 
+     * - weights of the alternatives of a Re
+     * - distribution of the number of repetitions of a quantifier (*, +, ?, {n,m})
+     * - frequencies of the characters of a Set
+     * 
+     * Everything is compiled into alias tables when registered, so that each weighted
+     * pick during the generation costs the same as a uniform one.
+     * The weighting refers to the nodes of the ast, which must outlive it.
+     * 
+     * @see Generator::generate( const Re&, const Weighting& )
+     */
+    class Weighting
+    {
+    public:
+        struct RepetitionTable
+        {
+            std::size_t min;
+            AliasTable table;
+        };
+
+        struct CharacterTable
+        {
+            /** characters with an explicit frequency, index i of the table */
+            std::vector<char32_t> chars;
+
+            /** other characters of the set, picked uniformly on the last index of the table */
+            CharSet others;
+
+            AliasTable table;
+        };
+
+        /**
+         * @param generator generator the weighting will be used with,
+         *                  its settings bound the repetitions and the sets
+         */
+        explicit Weighting( const Generator& generator );
+
+        /**
+         * weights the alternatives of a regex, e.g. the content of a group
+         * 
+         * @param re regex whose alternatives are weighted
+         * @param weights one weight per alternative
+         */
+        void alternatives( const Re& re, const std::vector<double>& weights )
+        {
+            if( weights.size() != re.size() )
+                throw std::runtime_error( "expected " + std::to_string( re.size() ) + " alternative weights, got "
+                                            + std::to_string( weights.size() ) );
+
+            m_alternatives.erase( &re );
+            m_alternatives.emplace( &re, AliasTable( weights ) );
+        }
+
+        /**
+         * sets the distribution of the number of repetitions of a quantifier
+         * 
+         * @param bre quantified regex (*, +, ? or {n,m})
+         * @param distribution distribution of the number of repetitions
+         */
+        void repetitions( const BasicRe& bre, const Distribution& distribution );
+
+        /**
+         * sets the frequencies of the characters of a set
+         * 
+         * characters which cannot be generated by the set are ignored
+         * 
+         * @param se set whose characters are weighted
+         * @param frequencies weight of each listed character
+         * @param others weight of each character of the set which is not listed
+         */
+        void characters( const Set& se, const std::map<char32_t, double>& frequencies, double others = 0 );
+
+        const AliasTable* alternatives( const Re& re ) const
+        {
+            auto it = m_alternatives.find( &re );
+            return it == m_alternatives.end() ? nullptr : &it->second;
+        }
+
+        const RepetitionTable* repetitions( const BasicReSub& quantifier ) const
+        {
+            auto it = m_repetitions.find( &quantifier );
+            return it == m_repetitions.end() ? nullptr : &it->second;
+        }
+
+        const CharacterTable* characters( const Set& se ) const
+        {
+            auto it = m_characters.find( &se );
+            return it == m_characters.end() ? nullptr : &it->second;
+        }
+
+    private:
+        /** copy of the generator the weighting is compiled for */
+        std::shared_ptr<const Generator> m_generator;
+
+        std::unordered_map<const Re*, AliasTable> m_alternatives;
+        std::unordered_map<const BasicReSub*, RepetitionTable> m_repetitions;
+        std::unordered_map<const Set*, CharacterTable> m_characters;
+    };
+}
\ No newline at end of file
@@ -26,6 +26,19 @@
 #include "Lexer.hpp"
 #include "Parser.hpp"
 #include "Generator.hpp"
+#include "Analysis.hpp"
+#include "Pattern.hpp"
+#include "Stream.hpp"
+#include "Matcher.hpp"
+#include "Sampler.hpp"
+#include "Jobs.hpp"
+#include "Coverage.hpp"
+#include "Library.hpp"
+#include "MappedDictionary.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 
 namespace regen
 {
@@ -42,9 +55,140 @@ namespace regen
      */
     inline std::string generate( const std::string& regextr,
                 Generator generator = Generator() )
+    {
+        return Pattern( regextr, generator ).generate();
+    }
+
+    /**
+     * generates a random string matching the given regular expression and writes it
+     * to a sink in chunks, e.g. to produce strings too large to be held in memory
+     * 
+     * @param regex regular expression
+     * @param sink called with each chunk of the string (@see fileSink)
+     * @param generator Generator used to generate the string. @see Generator for default parameters
+     * 
+     * @throw std::runtime_error error processing the regex (i.e. invalid regex)
+     * @throw std::logic_error probably a problem with the code :)
+     */
+    inline void generate( const std::string& regextr,
+                const Generator::Sink& sink,
+                Generator generator = Generator() )
+    {
+        auto tokens = lexer( regextr );
+        auto regex = Parser().parse( tokens );
+        generator.generate( regex, sink );
+    }
+
+    /**
+     * @param file file the chunks are written to, e.g. stdout
+     * 
+     * @return a sink writing each chunk to a file, it throws std::runtime_error if a write fails
+     */
+    inline Generator::Sink fileSink( std::FILE* file )
+    {
+        return [file]( const char* data, std::size_t size )
+        {
+            if( std::fwrite( data, 1, size, file ) != size )
+                throw std::runtime_error( std::string( "cannot write the generated string: " ) + std::strerror( errno ) );
+        };
+    }
+
+    /**
+     * checks whether a whole string matches the given regular expression
+     * 
+     * to check many strings against the same regex, build a Matcher once instead
+     * 
+     * @param regex regular expression
+     * @param str string to check
+     * 
+     * @throw std::runtime_error error processing the regex (i.e. invalid regex)
+     * 
+     * @return true if the string matches
+     */
+    inline bool matches( const std::string& regextr, boost::string_view str )
+    {
+        auto tokens = lexer( regextr );
+        auto regex = Parser().parse( tokens );
+        return Matcher( regex ).matches( str );
+    }
+
+    /**
+     * generates a random string matching a regular expression but not another one,
+     * e.g. valid user names which are not reserved words
+     * 
+     * the string is one the generator could produce (its bounds on the repetitions apply), picked uniformly
+     * among those of at most maxLength bytes, to generate many strings build a LanguageSampler once instead
+     * the generator seeds the sampler, generators with the same seed give the same strings
+     * 
+     * @param regex regular expression the string is generated from
+     * @param excluded regular expression the string must not match
+     * @param maxLength maximum length of the string in bytes
+     * @param generator Generator whose settings restrict the characters of the string
+     * 
+     * @throw std::runtime_error error processing the regex or no such string exists
+     * 
+     * @return the generated string
+     */
+    inline std::string generateDifference( const std::string& regextr,
+                const std::string& excludedstr,
+                std::size_t maxLength,
+                const Generator& generator = Generator() )
+    {
+        auto tokens = lexer( regextr );
+        auto regex = Parser().parse( tokens );
+        auto excludedTokens = lexer( excludedstr );
+        auto excluded = Parser().parse( excludedTokens );
+        return LanguageSampler::difference( regex, excluded, maxLength, generator ).generate();
+    }
+
+    /**
+     * generates a random string which does not match the given regular expression
+     * 
+     * the string is made of the characters the generator produces for '.' and picked
+     * uniformly among those of at most maxLength bytes
+     * the generator seeds the sampler, generators with the same seed give the same strings
+     * 
+     * @param regex regular expression the string must not match
+     * @param maxLength maximum length of the string in bytes
+     * @param generator Generator whose settings restrict the characters of the string
+     * 
+     * @throw std::runtime_error error processing the regex or no such string exists
+     * 
+     * @return the generated string
+     */
+    inline std::string generateNonMatching( const std::string& regextr,
+                std::size_t maxLength,
+                const Generator& generator = Generator() )
+    {
+        auto tokens = lexer( regextr );
+        auto regex = Parser().parse( tokens );
+        return LanguageSampler::complement( regex, maxLength, generator ).generate();
+    }
+
+    /**
+     * generates a random string matching the given regular expression and starting with the given prefix
+     * 
+     * the string is one the generator could produce (its bounds on the repetitions apply), picked uniformly
+     * among those of at most maxLength bytes, to complete the same prefix many times build a LanguageSampler
+     * and its Completion once instead
+     * the generator seeds the sampler, generators with the same seed give the same strings
+     * 
+     * @param regex regular expression the string is generated from
+     * @param prefix beginning of the string (UTF-8 encoded)
+     * @param maxLength maximum length of the string in bytes, prefix included
+     * @param generator Generator whose settings restrict the characters of the string
+     * 
+     * @throw std::runtime_error error processing the regex or no such string exists
+     * 
+     * @return the generated string
+     */
+    inline std::string generateWithPrefix( const std::string& regextr,
+                boost::string_view prefix,
+                std::size_t maxLength,
+                const Generator& generator = Generator() )
     {
         auto tokens = lexer( regextr );
         auto regex = Parser().parse( tokens );
-        return generator.generate( regex );
+        return LanguageSampler::matching( regex, maxLength, generator ).complete( prefix ).generate();
     }
 }
\ No newline at end of file
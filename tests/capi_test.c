@@ -0,0 +1,117 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+/*
+ * capi_test: checks the C interface from C: compilation, batches, errors and release
+ * 
+ * usage: capi_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capi/regen.h"
+
+#define COUNT 3000
+
+static int s_errors = 0;
+
+static void check( int condition, const char* what )
+{
+    if( !condition )
+    {
+        fprintf( stderr, "error: %s\n", what );
+        ++s_errors;
+    }
+}
+
+/** generates a batch in freshly allocated buffers, released by the caller */
+static regen_status batch( const regen_pattern* pattern, uint64_t seed, size_t threads, size_t capacity,
+                           char** buffer, size_t** offsets, size_t* generated )
+{
+    *buffer = malloc( capacity );
+    *offsets = malloc( ( COUNT + 1 ) * sizeof( size_t ) );
+    return regen_generate_batch( pattern, seed, COUNT, threads, *buffer, capacity, *offsets, generated );
+}
+
+int main( void )
+{
+    regen_pattern* pattern = NULL;
+    char* buffers[3];
+    size_t* offsets[3];
+    size_t generated[3];
+    size_t capacity;
+    size_t i;
+
+    check( regen_compile( "[A-Z]{3}-[0-9]{2,4}(x|yz)?", 5, 0, NULL, &pattern ) == REGEN_OK, "the regex does not compile" );
+    if( !pattern )
+        return 1;
+    check( regen_max_length( pattern ) == 10, "unexpected maximum length" );
+
+    /* the same seed gives the same strings, whatever the number of threads */
+    capacity = COUNT * regen_max_length( pattern );
+    check( batch( pattern, 42, 1, capacity, &buffers[0], &offsets[0], &generated[0] ) == REGEN_OK, "the first batch failed" );
+    check( batch( pattern, 42, 0, capacity, &buffers[1], &offsets[1], &generated[1] ) == REGEN_OK, "the second batch failed" );
+    check( batch( pattern, 43, 1, capacity, &buffers[2], &offsets[2], &generated[2] ) == REGEN_OK, "the third batch failed" );
+    check( generated[0] == COUNT && generated[1] == COUNT, "missing strings" );
+    check( memcmp( offsets[0], offsets[1], ( COUNT + 1 ) * sizeof( size_t ) ) == 0
+           && memcmp( buffers[0], buffers[1], offsets[0][COUNT] ) == 0, "the same seed gives different strings" );
+    check( offsets[0][COUNT] != offsets[2][COUNT] || memcmp( buffers[0], buffers[2], offsets[0][COUNT] ) != 0,
+           "different seeds give the same strings" );
+    for( i = 0; i < COUNT; ++i )
+    {
+        const size_t length = offsets[0][i + 1] - offsets[0][i];
+        if( length < 6 || length > 10 || buffers[0][offsets[0][i] + 3] != '-' )
+        {
+            check( 0, "a string does not match the regex" );
+            break;
+        }
+    }
+    for( i = 0; i < 3; ++i )
+    {
+        free( buffers[i] );
+        free( offsets[i] );
+    }
+
+    /* a small buffer gets the strings which fit */
+    check( batch( pattern, 42, 1, 100, &buffers[0], &offsets[0], &generated[0] ) == REGEN_BUFFER_TOO_SMALL, "a small buffer did not fail" );
+    check( generated[0] > 0 && generated[0] < COUNT && offsets[0][generated[0]] <= 100, "unexpected strings in a small buffer" );
+    check( strlen( regen_last_error() ) > 0, "no error message for a small buffer" );
+    free( buffers[0] );
+    free( offsets[0] );
+
+    regen_free( pattern );
+    regen_free( NULL );
+
+    /* errors */
+    pattern = NULL;
+    check( regen_compile( "[a-z", 5, 0, NULL, &pattern ) == REGEN_INVALID_REGEX && !pattern, "an invalid regex compiled" );
+    check( strlen( regen_last_error() ) > 0, "no error message for an invalid regex" );
+    check( regen_compile( NULL, 5, 0, NULL, &pattern ) == REGEN_INVALID_ARGUMENT, "a NULL regex compiled" );
+    check( regen_generate_batch( NULL, 0, 1, 1, NULL, 0, NULL, NULL ) == REGEN_INVALID_ARGUMENT, "a NULL pattern generated" );
+
+    printf( "%s\n", s_errors == 0 ? "ok" : "failed" );
+    return s_errors == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+/*
+ * codegen_test: checks that the functions generated by regen-codegen draw the same strings
+ * as a regen::Generator with the same settings and the same seed
+ * 
+ * usage: codegen_test codegen_patterns.txt
+ * 
+ * the headers are generated by the build from codegen_patterns.txt, once with the default
+ * settings (namespace patterns) and once with --max 3 --min 1 --range "[A-Za-z0-9\sàéè\x{4E00}-\x{4E0F}]"
+ * (namespace restricted)
+ */
+
+#include <fstream>
+#include <iostream>
+
+#include "regen/regen.hpp"
+
+#include "codegen_patterns.hpp"
+#include "codegen_restricted.hpp"
+
+namespace
+{
+    typedef std::string ( *Function )( boost::random::mt19937& );
+
+    struct Compiled
+    {
+        const char* name;
+        Function function;
+        std::size_t maxLength;
+    };
+
+#define REGEN_COMPILED( ns, name ) { #name, static_cast<Function>( &ns::name ), ns::name##_max_length }
+
+    const Compiled s_patterns[] = {
+        REGEN_COMPILED( patterns, plate ),
+        REGEN_COMPILED( patterns, email ),
+        REGEN_COMPILED( patterns, sentence ),
+        REGEN_COMPILED( patterns, negated ),
+        REGEN_COMPILED( patterns, any ),
+        REGEN_COMPILED( patterns, classes ),
+        REGEN_COMPILED( patterns, unicode ),
+        REGEN_COMPILED( patterns, nested ),
+        REGEN_COMPILED( patterns, words ),
+        REGEN_COMPILED( patterns, digits ),
+        REGEN_COMPILED( patterns, path ),
+    };
+
+    const Compiled s_restricted[] = {
+        REGEN_COMPILED( restricted, plate ),
+        REGEN_COMPILED( restricted, email ),
+        REGEN_COMPILED( restricted, sentence ),
+        REGEN_COMPILED( restricted, negated ),
+        REGEN_COMPILED( restricted, any ),
+        REGEN_COMPILED( restricted, classes ),
+        REGEN_COMPILED( restricted, unicode ),
+        REGEN_COMPILED( restricted, nested ),
+        REGEN_COMPILED( restricted, words ),
+        REGEN_COMPILED( restricted, digits ),
+        REGEN_COMPILED( restricted, path ),
+    };
+
+#undef REGEN_COMPILED
+
+    const std::uint64_t s_seeds = 20;
+    const std::size_t s_strings = 50;
+
+    /** @return the name and regex of each pattern of the file, in order */
+    std::vector<std::pair<std::string, std::string>> load( const std::string& path )
+    {
+        std::ifstream in( path );
+        if( !in )
+            throw std::runtime_error( "cannot open " + path );
+
+        std::vector<std::pair<std::string, std::string>> res;
+        std::string text;
+        while( std::getline( in, text ) )
+        {
+            if( text.empty() || text[0] == '#' )
+                continue;
+            const std::size_t space = text.find_first_of( " \t" );
+            res.emplace_back( text.substr( 0, space ), text.substr( text.find_first_not_of( " \t", space ) ) );
+        }
+        return res;
+    }
+
+    /**
+     * @return number of mismatches between the compiled functions and a generator
+     */
+    std::size_t check( const std::vector<std::pair<std::string, std::string>>& regexes,
+                        const Compiled* compiled, std::size_t count, regen::Generator generator )
+    {
+        if( regexes.size() != count )
+            throw std::runtime_error( "the pattern file does not match the compiled patterns" );
+
+        std::size_t mismatches = 0;
+        for( std::size_t i = 0; i < count; ++i )
+        {
+            if( regexes[i].first != compiled[i].name )
+                throw std::runtime_error( "expected pattern " + std::string( compiled[i].name ) + ", got " + regexes[i].first );
+
+            auto tokens = regen::lexer( regexes[i].second );
+            const regen::Re re = regen::Parser().parse( tokens );
+
+            for( std::uint64_t seed = 0; seed < s_seeds; ++seed )
+            {
+                boost::random::mt19937 rng;
+                regen_codegen::seed( rng, seed );
+                generator.seed( seed );
+
+                for( std::size_t n = 0; n < s_strings; ++n )
+                {
+                    const std::string expected = generator.generate( re );
+                    const std::string actual = compiled[i].function( rng );
+                    if( actual != expected || actual.size() > compiled[i].maxLength )
+                    {
+                        if( mismatches++ == 0 )
+                            std::cerr << compiled[i].name << " (seed " << seed << ", string " << n << "): expected \""
+                                      << expected << "\", got \"" << actual << "\"\n";
+                        break;
+                    }
+                }
+            }
+        }
+        return mismatches;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    if( argc != 2 )
+    {
+        std::cerr << "usage: codegen_test codegen_patterns.txt\n";
+        return 2;
+    }
+
+    try
+    {
+        const auto regexes = load( argv[1] );
+        const std::size_t mismatches =
+            check( regexes, s_patterns, sizeof( s_patterns ) / sizeof( *s_patterns ), regen::Generator() )
+            + check( regexes, s_restricted, sizeof( s_restricted ) / sizeof( *s_restricted ), regen::Generator( 3, 1, "[A-Za-z0-9\\sàéè\\x{4E00}-\\x{4E0F}]" ) );
+
+        std::cout << regexes.size() << " patterns, " << mismatches << " mismatches\n";
+        return mismatches == 0 ? 0 : 1;
+    }
+    catch( std::exception& ex )
+    {
+        std::cerr << "error: " << ex.what() << "\n";
+        return 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#!/bin/sh
+# starts regen-server on a temporary socket and runs regen-loadtest against it with a fixed seed,
+# the load test fails if a request fails or if the server and the clients count different strings
+#
+# usage: server_test.sh regen-server regen-loadtest patterns.txt
+
+set -e
+
+dir=$(mktemp -d)
+server=
+trap '[ -n "$server" ] && kill $server 2>/dev/null; wait 2>/dev/null; rm -rf "$dir"' EXIT
+
+"$1" --threads 2 "$3" "$dir/socket" 2>"$dir/server.log" &
+server=$!
+
+tries=0
+while [ ! -S "$dir/socket" ]; do
+    tries=$((tries + 1))
+    if [ $tries -gt 100 ] || ! kill -0 $server 2>/dev/null; then
+        cat "$dir/server.log"
+        exit 1
+    fi
+    sleep 0.1
+done
+
+"$2" --clients 4 --requests 200 --count 1500 --depth 4 --patterns 11 --seed 1 --check "$dir/socket"
@@ -0,0 +1,538 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+/*
+ * regen-codegen: compiles a file of patterns into a C++ header
+ * 
+ * each line of the pattern file is a name (a C++ identifier) followed by a regex,
+ * empty lines and lines starting with # are ignored:
+ * 
+ *     plate [A-Z]{3}[0-9]{6}
+ *     word  [a-z]+
+ * 
+ * for each pattern the header has a function writing a string into a caller buffer
+ * of at least <name>_max_length bytes, without allocating nor walking an ast:
+ * 
+ *     std::size_t plate( boost::random::mt19937& rng, char* out );
+ * 
+ * the functions make the same random draws as a regen::Generator with the same settings:
+ * seeded with regen_codegen::seed and the same seed, they generate the same strings.
+ * 
+ * usage: regen-codegen [--max N] [--min N] [--range SET] [--namespace NS] patterns.txt output.hpp
+ */
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cctype>
+
+#include "regen/regen.hpp"
+
+namespace
+{
+    /** largest number of repetitions unrolled */
+    const std::size_t s_maxUnroll = 16;
+
+    /** helpers shared by the generated functions, guarded as several headers may be included */
+    const char* s_prelude = R"(#ifndef REGEN_CODEGEN_PRELUDE
+#define REGEN_CODEGEN_PRELUDE
+
+namespace regen_codegen
+{
+    struct Interval
+    {
+        char32_t first;
+        char32_t last;
+        std::size_t offset;
+    };
+
+    /** seeds rng the same way as regen::Generator::seed */
+    inline void seed( boost::random::mt19937& rng, std::uint64_t seed )
+    {
+        boost::random::seed_seq seq{ static_cast<std::uint32_t>( seed ), static_cast<std::uint32_t>( seed >> 32 ) };
+        rng.seed( seq );
+    }
+
+    /** @return the n-th code point of a set given as intervals */
+    inline char32_t at( const Interval* intervals, std::size_t count, std::size_t n )
+    {
+        std::size_t lo = 0;
+        while( count > 1 )
+        {
+            const std::size_t half = count / 2;
+            if( intervals[lo + half].offset <= n )
+                lo += half;
+            count -= half;
+        }
+        return intervals[lo].first + static_cast<char32_t>( n - intervals[lo].offset );
+    }
+
+    /** writes a code point in UTF-8 @return the number of bytes written */
+    inline std::size_t put( char* out, char32_t c )
+    {
+        if( c < 0x80 )
+        {
+            out[0] = static_cast<char>( c );
+            return 1;
+        }
+        if( c < 0x800 )
+        {
+            out[0] = static_cast<char>( 0xC0 | ( c >> 6 ) );
+            out[1] = static_cast<char>( 0x80 | ( c & 0x3F ) );
+            return 2;
+        }
+        if( c < 0x10000 )
+        {
+            out[0] = static_cast<char>( 0xE0 | ( c >> 12 ) );
+            out[1] = static_cast<char>( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+            out[2] = static_cast<char>( 0x80 | ( c & 0x3F ) );
+            return 3;
+        }
+        out[0] = static_cast<char>( 0xF0 | ( c >> 18 ) );
+        out[1] = static_cast<char>( 0x80 | ( ( c >> 12 ) & 0x3F ) );
+        out[2] = static_cast<char>( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+        out[3] = static_cast<char>( 0x80 | ( c & 0x3F ) );
+        return 4;
+    }
+}
+
+#endif
+)";
+
+    /** @return a C++ string literal holding the given bytes */
+    std::string quote( const std::string& bytes )
+    {
+        static const char* digits = "0123456789abcdef";
+        std::string res = "\"";
+        bool escaped = false;
+        for( unsigned char c : bytes )
+        {
+            // a hex escape goes on until a non hex digit, so the literal is split after it
+            if( escaped && std::isxdigit( c ) )
+                res += "\" \"";
+            escaped = false;
+
+            if( c == '"' || c == '\\' )
+            {
+                res += '\\';
+                res += static_cast<char>( c );
+            }
+            else if( c >= 0x20 && c < 0x7F && c != '?' )
+            {
+                res += static_cast<char>( c );
+            }
+            else
+            {
+                res += "\\x";
+                res += digits[c >> 4];
+                res += digits[c & 0xF];
+                escaped = true;
+            }
+        }
+        return res + "\"";
+    }
+
+    /** @return the text of a doc comment, with any end of comment escaped */
+    std::string comment( const std::string& text )
+    {
+        std::string res;
+        for( char c : text )
+        {
+            if( c == '/' && !res.empty() && res.back() == '*' )
+                res += '\\';
+            res += c;
+        }
+        return res;
+    }
+
+    /**
+     * Emits the body of the function generating the strings of a regex
+     * 
+     * Mirrors the draws of regen::Generator: one draw per alternation, one per
+     * quantifier and one per character picked in a set of several characters.
+     * Literal characters are gathered and written with a single memcpy.
+     */
+    class Emitter
+    {
+    public:
+        Emitter( const regen::Generator& generator )
+        : m_generator( generator ),
+        m_indent( 2 ),
+        m_counter( 0 ),
+        m_random( false )
+        {
+        }
+
+        std::string emit( const regen::Re& re )
+        {
+            generate( re );
+            flush();
+            return m_code.str();
+        }
+
+        /** @return whether the emitted code draws random numbers */
+        bool random() const { return m_random; }
+
+    private:
+        void line( const std::string& code )
+        {
+            m_code << std::string( m_indent * 4, ' ' ) << code << "\n";
+        }
+
+        void open( const std::string& code )
+        {
+            flush();
+            line( code );
+            line( "{" );
+            ++m_indent;
+        }
+
+        void close()
+        {
+            flush();
+            --m_indent;
+            line( "}" );
+        }
+
+        /** writes the pending literal bytes */
+        void flush()
+        {
+            if( m_pending.empty() )
+                return;
+
+            if( m_pending.size() == 1 )
+                line( "out[n++] = " + std::to_string( static_cast<int>( static_cast<signed char>( m_pending[0] ) ) ) + ";" );
+            else
+                line( "std::memcpy( out + n, " + quote( m_pending ) + ", " + std::to_string( m_pending.size() ) + " ); n += " + std::to_string( m_pending.size() ) + ";" );
+            m_pending.clear();
+        }
+
+        std::string dice( const std::string& type, std::size_t min, std::size_t max )
+        {
+            m_random = true;
+            return "boost::random::uniform_int_distribution<" + type + ">( " + std::to_string( min ) + ", " + std::to_string( max ) + " )( rng )";
+        }
+
+        std::string name( const char* prefix )
+        {
+            return prefix + std::to_string( m_counter++ );
+        }
+
+        void generate( const regen::Re& re )
+        {
+            if( re.literals )
+                return generateLiterals( *re.literals );
+            const auto& unionRes = re.unionRes();
+            if( unionRes.size() == 1 )
+                return generate( unionRes.front() );
+
+            open( "switch( " + dice( "", 0, unionRes.size() - 1 ) + " )" );
+            for( std::size_t i = 0; i < unionRes.size(); ++i )
+            {
+                open( "case " + std::to_string( i ) + ":" );
+                generate( unionRes[i] );
+                flush();
+                line( "break;" );
+                close();
+            }
+            close();
+        }
+
+        /** a packed alternation of literals: a table of the bytes and one of the offsets */
+        void generateLiterals( const regen::Literals& literals )
+        {
+            flush();
+            const std::string table = name( "literals" );
+            std::ostringstream offsets;
+            for( std::uint32_t offset : literals.offsets )
+                offsets << " " << offset << ",";
+            line( "static const char " + table + "_data[] = " + quote( literals.data ) + ";" );
+            line( "static const std::uint32_t " + table + "_offsets[] = {" + offsets.str() + " };" );
+
+            const std::string k = name( "k" );
+            const std::string length = table + "_offsets[" + k + " + 1] - " + table + "_offsets[" + k + "]";
+            line( "const std::size_t " + k + " = " + dice( "", 0, literals.size() - 1 ) + ";" );
+            line( "std::memcpy( out + n, " + table + "_data + " + table + "_offsets[" + k + "], " + length + " ); n += " + length + ";" );
+        }
+
+        void generate( const regen::SimpleRe& sre )
+        {
+            for( const regen::BasicRe& bre : sre.concatRes )
+                generate( *bre.sub );
+        }
+
+        void generate( const regen::BasicReSub& sub )
+        {
+            if( auto ptr = dynamic_cast<const regen::Star*>( &sub ) )
+                return generateRepetition( sub, *ptr->re );
+            if( auto ptr = dynamic_cast<const regen::Plus*>( &sub ) )
+                return generateRepetition( sub, *ptr->re );
+            if( auto ptr = dynamic_cast<const regen::Question*>( &sub ) )
+                return generateRepetition( sub, *ptr->re );
+            if( auto ptr = dynamic_cast<const regen::NumericRange*>( &sub ) )
+                return generateRepetition( sub, *ptr->re );
+            if( auto ptr = dynamic_cast<const regen::Group*>( &sub ) )
+                return generate( ptr->re );
+            if( auto ptr = dynamic_cast<const regen::Any*>( &sub ) )
+                return pick( m_generator.resolve( *ptr ) );
+            if( auto ptr = dynamic_cast<const regen::Char*>( &sub ) )
+                return regen::appendUtf8( m_pending, ptr->c );
+            if( auto ptr = dynamic_cast<const regen::Set*>( &sub ) )
+                return pick( m_generator.resolve( *ptr ) );
+            if( auto ptr = dynamic_cast<const regen::Reference*>( &sub ) )
+                throw std::runtime_error( "dictionary reference {" + ptr->name + "} cannot be generated as code" );
+
+            throw std::logic_error( "unknown basic-re type" );
+        }
+
+        void generateRepetition( const regen::BasicReSub& quantifier, const regen::ElementaryRe& ere )
+        {
+            const auto bounds = m_generator.repetitionBounds( quantifier );
+            auto c = dynamic_cast<const regen::Char*>( &ere );
+            if( bounds.first == bounds.second && c )
+            {
+                for( std::size_t i = 0; i < bounds.first; ++i )
+                    regen::appendUtf8( m_pending, c->c );
+                return;
+            }
+            if( bounds.first == bounds.second && bounds.first <= s_maxUnroll )
+            {
+                for( std::size_t i = 0; i < bounds.first; ++i )
+                    generate( ere );
+                return;
+            }
+
+            const std::string i = name( "i" );
+            if( bounds.first == bounds.second )
+                open( "for( std::size_t " + i + " = 0; " + i + " < " + std::to_string( bounds.first ) + "; ++" + i + " )" );
+            else
+                open( "for( int " + i + " = 0, " + i + "_count = " + dice( "", bounds.first, bounds.second ) + "; " + i + " < " + i + "_count; ++" + i + " )" );
+            generate( ere );
+            close();
+        }
+
+        /** picks a character uniformly in a set, as Generator::pick */
+        void pick( const regen::CharSet& set )
+        {
+            if( set.empty() )
+            {
+                flush();
+                line( "throw std::runtime_error( \"no character can be generated from an empty set\" );" );
+                return;
+            }
+            if( set.size() == 1 )
+                return regen::appendUtf8( m_pending, set[0] );
+
+            flush();
+            const std::string dice = this->dice( "std::size_t", 0, set.size() - 1 );
+            const auto& intervals = set.intervals();
+
+            if( intervals.size() == 1 && intervals.front().last < 0x80 )
+            {
+                line( "out[n++] = static_cast<char>( " + std::to_string( intervals.front().first ) + " + " + dice + " );" );
+            }
+            else if( intervals.size() == 1 )
+            {
+                line( "n += regen_codegen::put( out + n, static_cast<char32_t>( " + std::to_string( intervals.front().first ) + " + " + dice + " ) );" );
+            }
+            else if( intervals.back().last < 0x80 )
+            {
+                std::string table;
+                for( std::size_t i = 0; i < set.size(); ++i )
+                    table += static_cast<char>( set[i] );
+                line( "out[n++] = " + quote( table ) + "[" + dice + "];" );
+            }
+            else
+            {
+                const std::string table = name( "set" );
+                std::ostringstream init;
+                std::size_t offset = 0;
+                for( const auto& interval : intervals )
+                {
+                    init << " { " << interval.first << ", " << interval.last << ", " << offset << " },";
+                    offset += interval.last - interval.first + 1;
+                }
+                line( "static const regen_codegen::Interval " + table + "[] = {" + init.str() + " };" );
+                line( "n += regen_codegen::put( out + n, regen_codegen::at( " + table + ", " + std::to_string( intervals.size() ) + ", " + dice + " ) );" );
+            }
+        }
+
+        const regen::Generator& m_generator;
+
+        std::ostringstream m_code;
+        std::size_t m_indent;
+
+        /** literal bytes not written yet */
+        std::string m_pending;
+
+        /** suffix of the local names */
+        std::size_t m_counter;
+
+        bool m_random;
+    };
+
+    bool isIdentifier( const std::string& name )
+    {
+        if( name.empty() || std::isdigit( static_cast<unsigned char>( name[0] ) ) )
+            return false;
+        for( unsigned char c : name )
+            if( !std::isalnum( c ) && c != '_' )
+                return false;
+        return true;
+    }
+
+    /**
+     * @return the functions of a pattern
+     */
+    std::string compile( const std::string& name, const std::string& regex, const regen::Generator& generator )
+    {
+        auto tokens = regen::lexer( regex );
+        auto re = regen::Parser().parse( tokens );
+
+        const std::size_t maxLength = regen::Analysis( re, generator ).stats().maxLength;
+        if( maxLength == std::numeric_limits<std::size_t>::max() )
+            throw std::runtime_error( "the strings of " + name + " are too long" );
+
+        Emitter emitter( generator );
+        const std::string body = emitter.emit( re );
+
+        std::ostringstream res;
+        res << "    /** " << comment( regex ) << " */\n"
+            << "    constexpr std::size_t " << name << "_max_length = " << maxLength << ";\n\n"
+            << "    /**\n"
+            << "     * writes a random string matching " << name << " in out, which has room for " << name << "_max_length bytes\n"
+            << "     * @return the length of the string\n"
+            << "     */\n"
+            << "    inline std::size_t " << name << "( boost::random::mt19937& " << ( emitter.random() ? "rng" : "/*rng*/" ) << ", char* out )\n"
+            << "    {\n"
+            << "        std::size_t n = 0;\n"
+            << body
+            << "        return n;\n"
+            << "    }\n\n"
+            << "    inline std::string " << name << "( boost::random::mt19937& rng )\n"
+            << "    {\n"
+            << "        std::string res( " << name << "_max_length, '\\0' );\n"
+            << "        res.resize( " << name << "( rng, &res[0] ) );\n"
+            << "        return res;\n"
+            << "    }\n";
+        return res.str();
+    }
+
+    int usage()
+    {
+        std::cerr << "usage: regen-codegen [--max N] [--min N] [--range SET] [--namespace NS] patterns.txt output.hpp\n";
+        return 2;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    std::size_t repetition_max = 5;
+    std::size_t repetition_min = 0;
+    std::string restricted_range;
+    std::string ns = "patterns";
+    std::vector<std::string> files;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[i];
+        if( arg.compare( 0, 2, "--" ) != 0 )
+            files.push_back( arg );
+        else if( i + 1 == argc )
+            return usage();
+        else if( arg == "--max" )
+            repetition_max = std::stoul( argv[++i] );
+        else if( arg == "--min" )
+            repetition_min = std::stoul( argv[++i] );
+        else if( arg == "--range" )
+            restricted_range = argv[++i];
+        else if( arg == "--namespace" )
+            ns = argv[++i];
+        else
+            return usage();
+    }
+    if( files.size() != 2 )
+        return usage();
+
+    try
+    {
+        const regen::Generator generator( repetition_max, repetition_min, restricted_range );
+
+        std::ifstream in( files[0] );
+        if( !in )
+            throw std::runtime_error( "cannot open " + files[0] );
+
+        std::ostringstream functions;
+        std::string text;
+        for( std::size_t lineNumber = 1; std::getline( in, text ); ++lineNumber )
+        {
+            if( !text.empty() && text.back() == '\r' )
+                text.pop_back();
+            if( text.empty() || text[0] == '#' )
+                continue;
+
+            const std::size_t space = text.find_first_of( " \t" );
+            const std::string name = text.substr( 0, space );
+            const std::size_t start = space == std::string::npos ? space : text.find_first_not_of( " \t", space );
+            if( !isIdentifier( name ) || start == std::string::npos )
+                throw std::runtime_error( files[0] + ":" + std::to_string( lineNumber ) + ": expected a name and a regex" );
+
+            try
+            {
+                functions << "\n" << compile( name, text.substr( start ), generator );
+            }
+            catch( std::exception& ex )
+            {
+                throw std::runtime_error( files[0] + ":" + std::to_string( lineNumber ) + ": " + ex.what() );
+            }
+        }
+
+        std::ofstream out( files[1] );
+        out << "// generated by regen-codegen from " << files[0] << ", do not edit\n"
+            << "// settings: max repetitions " << repetition_max << ", min repetitions " << repetition_min
+            << ", range \"" << restricted_range << "\"\n\n"
+            << "#pragma once\n\n"
+            << "#include <boost/random/mersenne_twister.hpp>\n"
+            << "#include <boost/random/uniform_int_distribution.hpp>\n"
+            << "#include <boost/random/seed_seq.hpp>\n\n"
+            << "#include <cstdint>\n"
+            << "#include <cstring>\n"
+            << "#include <stdexcept>\n"
+            << "#include <string>\n\n"
+            << s_prelude << "\n"
+            << "namespace " << ns << "\n"
+            << "{"
+            << functions.str()
+            << "}\n";
+        if( !out )
+            throw std::runtime_error( "cannot write " + files[1] );
+    }
+    catch( std::exception& ex )
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
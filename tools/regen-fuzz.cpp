@@ -0,0 +1,288 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+/*
+ * regen-fuzz: checks that the strings generated from random patterns match them
+ * 
+ * each pattern is built from a small grammar (characters, escapes, classes, sets, groups,
+ * alternations and quantifiers), strings are generated from it with several seeds and each one
+ * is checked with a regen::Matcher, and with std::regex when the pattern is ASCII.
+ * A mismatch prints the pattern, the seed and the string, and exits with 1.
+ * 
+ * usage: regen-fuzz [--iterations N] [--seed N] [--strings N] [corpus.txt...]
+ * 
+ * the patterns of the corpus files (one per line) are checked before the random ones.
+ * 
+ * Built with -DREGEN_LIBFUZZER -fsanitize=fuzzer, it is a libFuzzer target instead:
+ * the input is a seed (its first 8 bytes) followed by a pattern.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <regex>
+
+#include "regen/regen.hpp"
+
+namespace
+{
+    /**
+     * builds random patterns, nested up to a depth
+     */
+    class PatternBuilder
+    {
+    public:
+        explicit PatternBuilder( std::uint64_t seed )
+        : m_rng( seed )
+        {
+        }
+
+        std::string operator()()
+        {
+            return re( 3 );
+        }
+
+    private:
+        std::size_t below( std::size_t n )
+        {
+            return std::uniform_int_distribution<std::size_t>( 0, n - 1 )( m_rng );
+        }
+
+        std::string re( int depth )
+        {
+            std::string res = simpleRe( depth );
+            while( below( 4 ) == 0 )
+                res += "|" + simpleRe( depth );
+            return res;
+        }
+
+        std::string simpleRe( int depth )
+        {
+            std::string res;
+            const std::size_t length = 1 + below( 4 );
+            for( std::size_t i = 0; i < length; ++i )
+                res += basicRe( depth );
+            return res;
+        }
+
+        std::string basicRe( int depth )
+        {
+            static const char* quantifiers[] = { "*", "+", "?", "{2}", "{0,3}", "{1,}", "{3,5}" };
+
+            std::string res = elementaryRe( depth );
+            if( below( 3 ) == 0 )
+                res += quantifiers[below( sizeof( quantifiers ) / sizeof( *quantifiers ) )];
+            return res;
+        }
+
+        std::string elementaryRe( int depth )
+        {
+            static const char* chars[] = { "a", "b", "z", "0", "9", "_", "-", " ", ",", "\\.", "\\*", "\\(", "\\[", "\\\\", "\\{",
+                                           "\xC3\xA9", "\xE6\x97\xA5", "\xF0\x9F\x98\x80" };
+            static const char* classes[] = { ".", "\\d", "\\w", "\\s" };
+            static const char* sets[] = { "[abc]", "[a-f0-9]", "[^x]", "[^a-z]", "[\\d_]", "[\\w\\-]", "[^\\s]",
+                                          "[\xC3\xA0-\xC3\xBF]", "[a\xE6\x97\xA5]" };
+
+            const std::size_t kind = below( depth > 0 ? 5 : 4 );
+            if( kind <= 1 )
+                return chars[below( sizeof( chars ) / sizeof( *chars ) )];
+            if( kind == 2 )
+                return classes[below( sizeof( classes ) / sizeof( *classes ) )];
+            if( kind == 3 )
+                return sets[below( sizeof( sets ) / sizeof( *sets ) )];
+            return "(" + re( depth - 1 ) + ")";
+        }
+
+        std::mt19937_64 m_rng;
+    };
+
+    bool isAscii( const std::string& str )
+    {
+        for( unsigned char c : str )
+            if( c >= 0x80 )
+                return false;
+        return true;
+    }
+
+    /**
+     * generates strings from a pattern and checks them
+     * 
+     * @return false if a string does not match, after printing it
+     */
+    bool check( const std::string& regex, std::uint64_t seed, std::size_t strings )
+    {
+        regen::Re re;
+        try
+        {
+            auto tokens = regen::lexer( regex );
+            re = regen::Parser().parse( tokens );
+        }
+        catch( std::runtime_error& )
+        {
+            // invalid patterns are not the subject
+            return true;
+        }
+
+        std::unique_ptr<regen::Matcher> matcher;
+        try
+        {
+            matcher.reset( new regen::Matcher( re ) );
+        }
+        catch( std::runtime_error& )
+        {
+            // e.g. {name} references, which cannot be matched
+            return true;
+        }
+
+        std::unique_ptr<std::regex> reference;
+        if( isAscii( regex ) )
+        {
+            try
+            {
+                reference.reset( new std::regex( regex ) );
+            }
+            catch( std::regex_error& )
+            {
+            }
+        }
+
+        regen::Budget budget;
+        budget.maxBytes = 1 << 12;
+        budget.maxVisits = 1 << 14;
+
+        regen::Generator generator;
+        for( std::size_t i = 0; i < strings; ++i )
+        {
+            generator.seed( regen::substreamSeed( seed, i ) );
+            std::string str;
+            try
+            {
+                generator.generate( re, str, budget );
+            }
+            catch( regen::BudgetExceeded& )
+            {
+                continue;
+            }
+
+            const bool matched = matcher->matches( str );
+            const bool referenceMatched = !reference || std::regex_match( str, *reference );
+            if( !matched || !referenceMatched )
+            {
+                std::cerr << "mismatch (" << ( matched ? "std::regex" : "regen::Matcher" ) << ")\n"
+                          << "pattern: " << regex << "\n"
+                          << "seed: " << seed << ", string " << i << "\n"
+                          << "string: " << str << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+#ifdef REGEN_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput( const std::uint8_t* data, std::size_t size )
+{
+    std::uint64_t seed = 0;
+    if( size >= sizeof( seed ) )
+    {
+        std::memcpy( &seed, data, sizeof( seed ) );
+        data += sizeof( seed );
+        size -= sizeof( seed );
+    }
+
+    if( !check( std::string( reinterpret_cast<const char*>( data ), size ), seed, 16 ) )
+        std::abort();
+    return 0;
+}
+
+#else
+
+namespace
+{
+    int usage()
+    {
+        std::cerr << "usage: regen-fuzz [--iterations N] [--seed N] [--strings N] [corpus.txt...]\n";
+        return 2;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    std::size_t iterations = 10000;
+    std::uint64_t seed = std::random_device()();
+    std::size_t strings = 16;
+    std::vector<std::string> files;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[i];
+        if( arg.compare( 0, 2, "--" ) != 0 )
+            files.push_back( arg );
+        else if( i + 1 == argc )
+            return usage();
+        else if( arg == "--iterations" )
+            iterations = std::stoul( argv[++i] );
+        else if( arg == "--seed" )
+            seed = std::stoull( argv[++i] );
+        else if( arg == "--strings" )
+            strings = std::stoul( argv[++i] );
+        else
+            return usage();
+    }
+
+    std::size_t patterns = 0;
+    for( const std::string& file : files )
+    {
+        std::ifstream in( file );
+        if( !in )
+        {
+            std::cerr << "cannot open " << file << "\n";
+            return 2;
+        }
+        std::string regex;
+        while( std::getline( in, regex ) )
+        {
+            if( regex.empty() )
+                continue;
+            if( !check( regex, seed, strings ) )
+                return 1;
+            ++patterns;
+        }
+    }
+
+    std::cerr << "seed " << seed << "\n";
+    PatternBuilder builder( seed );
+    for( std::size_t i = 0; i < iterations; ++i, ++patterns )
+        if( !check( builder(), regen::substreamSeed( seed, i ), strings ) )
+            return 1;
+
+    std::cerr << patterns << " patterns checked\n";
+    return 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,300 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+/*
+ * regen-loadtest: measures the latency and throughput of a regen-server
+ * 
+ * each client opens a connection and keeps --depth GENERATE requests of --count strings
+ * in flight until it has sent --requests, the requests cycle over the first --patterns
+ * patterns of the library. The latency of a request is measured from its sending
+ * to its last frame. The statistics of the server are printed at the end.
+ * 
+ * --check fails unless every request succeeded and the server counted the strings and bytes
+ * the clients received, which holds for a server that served only this run.
+ * 
+ * usage: regen-loadtest [--clients N] [--requests N] [--count N] [--depth N] [--patterns N] [--seed N] [--check] socket
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/un.h>
+
+#include "regen-protocol.hpp"
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct Options
+    {
+        std::string path;
+        std::size_t clients = 4;
+        std::uint32_t requests = 1000;
+        std::uint32_t count = 100;
+        std::uint32_t depth = 4;
+        std::uint32_t patterns = 1;
+        std::uint64_t seed = 0;
+        bool check = false;
+    };
+
+    struct Result
+    {
+        /** of each request, in microseconds */
+        std::vector<double> latencies;
+        std::uint64_t strings = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t errors = 0;
+        std::string error;
+    };
+
+    int connectTo( const std::string& path )
+    {
+        sockaddr_un address;
+        std::memset( &address, 0, sizeof( address ) );
+        address.sun_family = AF_UNIX;
+        if( path.size() >= sizeof( address.sun_path ) )
+            throw std::runtime_error( "socket path too long: " + path );
+        std::strcpy( address.sun_path, path.c_str() );
+
+        const int fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+        if( fd < 0 || ::connect( fd, reinterpret_cast<const sockaddr*>( &address ), sizeof( address ) ) != 0 )
+        {
+            const std::string error = std::strerror( errno );
+            if( fd >= 0 )
+                ::close( fd );
+            throw std::runtime_error( "cannot connect to " + path + ": " + error );
+        }
+        regen_protocol::noSigPipe( fd );
+        return fd;
+    }
+
+    void exchange( int fd, const Options& options, std::size_t index, Result& res )
+    {
+        std::vector<Clock::time_point> sent( options.requests );
+        std::uint32_t next = 0;
+        std::uint32_t completed = 0;
+
+        auto request = [&]
+        {
+            const regen_protocol::Request r{ regen_protocol::GENERATE, next, next % options.patterns, options.count,
+                                             options.seed + index * options.requests + next };
+            sent[next++] = Clock::now();
+            if( !regen_protocol::writeAll( fd, &r, sizeof( r ) ) )
+                throw std::runtime_error( "cannot send a request" );
+        };
+
+        while( next < options.requests && next < options.depth )
+            request();
+
+        std::string payload;
+        while( completed < options.requests )
+        {
+            regen_protocol::Response response;
+            if( !regen_protocol::readAll( fd, &response, sizeof( response ) ) || response.id >= options.requests )
+                throw std::runtime_error( "connection closed by the server" );
+            payload.resize( response.size );
+            if( !regen_protocol::readAll( fd, &payload[0], payload.size() ) )
+                throw std::runtime_error( "connection closed by the server" );
+
+            if( response.status != regen_protocol::OK )
+            {
+                ++res.errors;
+                res.error = payload;
+            }
+            else
+            {
+                // the lengths of the strings, then the strings
+                if( std::uint64_t( response.count ) * sizeof( std::uint32_t ) > response.size )
+                    throw std::runtime_error( "inconsistent response frame" );
+                std::uint64_t bytes = 0;
+                for( std::uint32_t i = 0; i < response.count; ++i )
+                {
+                    std::uint32_t length;
+                    std::memcpy( &length, &payload[i * sizeof( length )], sizeof( length ) );
+                    bytes += length;
+                }
+                if( response.count * sizeof( std::uint32_t ) + bytes != response.size )
+                    throw std::runtime_error( "inconsistent response frame" );
+                res.strings += response.count;
+                res.bytes += bytes;
+            }
+
+            if( response.flags & regen_protocol::LAST )
+            {
+                res.latencies.push_back( std::chrono::duration<double, std::micro>( Clock::now() - sent[response.id] ).count() );
+                ++completed;
+                if( next < options.requests )
+                    request();
+            }
+        }
+    }
+
+    void client( const Options& options, std::size_t index, Result& res )
+    {
+        const int fd = connectTo( options.path );
+        try
+        {
+            exchange( fd, options, index, res );
+        }
+        catch( ... )
+        {
+            ::close( fd );
+            throw;
+        }
+        ::close( fd );
+    }
+
+    regen_protocol::Stats serverStats( const std::string& path )
+    {
+        const int fd = connectTo( path );
+        const regen_protocol::Request request{ regen_protocol::STATS, 0, 0, 0, 0 };
+        regen_protocol::Response response;
+        regen_protocol::Stats res;
+        const bool ok = regen_protocol::writeAll( fd, &request, sizeof( request ) )
+                        && regen_protocol::readAll( fd, &response, sizeof( response ) )
+                        && response.size == sizeof( res )
+                        && regen_protocol::readAll( fd, &res, sizeof( res ) );
+        ::close( fd );
+        if( !ok )
+            throw std::runtime_error( "cannot read the statistics of the server" );
+        return res;
+    }
+
+    int usage()
+    {
+        std::cerr << "usage: regen-loadtest [--clients N] [--requests N] [--count N] [--depth N] [--patterns N] [--seed N] [--check] socket\n";
+        return 2;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    Options options;
+    std::vector<std::string> files;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[i];
+        if( arg.compare( 0, 2, "--" ) != 0 )
+            files.push_back( arg );
+        else if( arg == "--check" )
+            options.check = true;
+        else if( i + 1 == argc )
+            return usage();
+        else if( arg == "--clients" )
+            options.clients = std::stoul( argv[++i] );
+        else if( arg == "--requests" )
+            options.requests = static_cast<std::uint32_t>( std::stoul( argv[++i] ) );
+        else if( arg == "--count" )
+            options.count = static_cast<std::uint32_t>( std::stoul( argv[++i] ) );
+        else if( arg == "--depth" )
+            options.depth = static_cast<std::uint32_t>( std::stoul( argv[++i] ) );
+        else if( arg == "--patterns" )
+            options.patterns = static_cast<std::uint32_t>( std::stoul( argv[++i] ) );
+        else if( arg == "--seed" )
+            options.seed = std::stoull( argv[++i] );
+        else
+            return usage();
+    }
+    if( files.size() != 1 || options.clients == 0 || options.depth == 0 || options.patterns == 0 )
+        return usage();
+    options.path = files[0];
+
+    try
+    {
+        std::vector<Result> results( options.clients );
+        std::vector<std::string> errors( options.clients );
+        std::vector<std::thread> clients;
+
+        const auto start = Clock::now();
+        for( std::size_t i = 0; i < options.clients; ++i )
+        {
+            clients.emplace_back( [&options, &results, &errors, i]
+            {
+                try
+                {
+                    client( options, i, results[i] );
+                }
+                catch( std::exception& ex )
+                {
+                    errors[i] = ex.what();
+                }
+            } );
+        }
+        for( std::thread& thread : clients )
+            thread.join();
+        const double seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+
+        Result total;
+        for( std::size_t i = 0; i < options.clients; ++i )
+        {
+            if( !errors[i].empty() )
+                throw std::runtime_error( "client " + std::to_string( i ) + ": " + errors[i] );
+            total.latencies.insert( total.latencies.end(), results[i].latencies.begin(), results[i].latencies.end() );
+            total.strings += results[i].strings;
+            total.bytes += results[i].bytes;
+            total.errors += results[i].errors;
+            if( !results[i].error.empty() )
+                total.error = results[i].error;
+        }
+        std::sort( total.latencies.begin(), total.latencies.end() );
+        auto percentile = [&total]( double ratio ) {
+            return total.latencies.empty() ? 0 : total.latencies[static_cast<std::size_t>( ratio * ( total.latencies.size() - 1 ) )];
+        };
+
+        std::cout << std::fixed << std::setprecision( 1 )
+                  << total.latencies.size() << " requests (" << total.errors << " failed), " << total.strings << " strings, "
+                  << total.bytes / 1e6 << " MB in " << seconds << " s\n"
+                  << "throughput: " << total.latencies.size() / seconds << " requests/s, " << total.strings / seconds << " strings/s, "
+                  << total.bytes / 1e6 / seconds << " MB/s\n"
+                  << "latency: p50 " << percentile( 0.5 ) << " p90 " << percentile( 0.9 ) << " p99 " << percentile( 0.99 )
+                  << " max " << percentile( 1 ) << " us\n";
+        if( total.errors > 0 )
+            std::cout << "last error: " << total.error << "\n";
+
+        const regen_protocol::Stats s = serverStats( options.path );
+        std::cout << "server: " << s.requests << " requests (" << s.failed << " failed), " << s.dropped << " connections dropped, "
+                  << s.strings << " strings, " << s.bytes / 1e6 << " MB in "
+                  << s.batches << " batches / " << s.tasks << " tasks, latency p50 " << s.latencyP50 << " p90 " << s.latencyP90
+                  << " p99 " << s.latencyP99 << " max " << s.latencyMax << " us\n";
+
+        if( options.check && ( total.errors > 0 || s.failed > 0 || s.strings != total.strings || s.bytes != total.bytes ) )
+            throw std::runtime_error( "the server and the clients disagree, or requests failed" );
+    }
+    catch( std::exception& ex )
+    {
+        std::cerr << "error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+/*
+ * framing of the requests and responses exchanged over the Unix domain socket of regen-server
+ * 
+ * both ends run on the same host: integers are in the host byte order
+ * 
+ * a client sends Request frames and may send several before reading the responses.
+ * the server answers each request with one or more Response frames, each followed by
+ * Response::size bytes of payload:
+ * 
+ * - GENERATE: the strings first, first + 1, ... of the request, as count uint32 lengths
+ *   followed by the bytes of the strings. The frames of a request may come in any order
+ *   and interleaved with those of other requests, the last one has the LAST flag.
+ *   Strings are generated by blocks of s_blockSize seeded with regen::substreamSeed( seed, block ),
+ *   so a request always gets the same strings, as regen_generate_batch with the same seed.
+ * - STATS: a single frame whose payload is a Stats
+ * 
+ * a failed request gets a single frame with an error status whose payload is the error message,
+ * e.g. INVALID_REQUEST for a count above the --max-count of the server
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <csignal>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace regen_protocol
+{
+    /** strings generated from the same seed, and at most in a Response */
+    const std::uint32_t s_blockSize = 1024;
+
+    enum EType : std::uint32_t
+    {
+        GENERATE = 1,
+        STATS = 2
+    };
+
+    enum EStatus : std::uint32_t
+    {
+        OK = 0,
+        INVALID_REQUEST,
+        INVALID_PATTERN,
+        FAILED
+    };
+
+    enum EFlags : std::uint32_t
+    {
+        LAST = 1
+    };
+
+    struct Request
+    {
+        std::uint32_t type;
+
+        /** chosen by the client, echoed in the responses */
+        std::uint32_t id;
+
+        /** GENERATE: index of the pattern in the library, number of strings and seed */
+        std::uint32_t pattern;
+        std::uint32_t count;
+        std::uint64_t seed;
+    };
+
+    struct Response
+    {
+        std::uint32_t type;
+        std::uint32_t id;
+        std::uint32_t status;
+        std::uint32_t flags;
+
+        /** GENERATE: index in the request of the first string and number of strings of the frame */
+        std::uint32_t first;
+        std::uint32_t count;
+
+        /** bytes of payload following the frame */
+        std::uint64_t size;
+    };
+
+    struct Stats
+    {
+        std::uint64_t requests;
+        std::uint64_t failed;
+
+        /** connections closed by the server because they did not read their responses */
+        std::uint64_t dropped;
+        std::uint64_t strings;
+
+        /** of the strings, without their length prefixes */
+        std::uint64_t bytes;
+
+        /** rounds of the dispatcher and tasks run by the workers, each round batches the waiting requests */
+        std::uint64_t batches;
+        std::uint64_t tasks;
+
+        /** from the reception of a request to its last frame, in microseconds */
+        std::uint64_t latencyP50;
+        std::uint64_t latencyP90;
+        std::uint64_t latencyP99;
+        std::uint64_t latencyMax;
+
+        double seconds;
+        double requestsPerSecond;
+        double bytesPerSecond;
+    };
+
+    static_assert( sizeof( Request ) == 24, "unexpected padding of Request" );
+    static_assert( sizeof( Response ) == 32, "unexpected padding of Response" );
+
+    /**
+     * reads exactly size bytes
+     * 
+     * @return false on error or end of stream
+     */
+    inline bool readAll( int fd, void* data, std::size_t size )
+    {
+        char* p = static_cast<char*>( data );
+        while( size > 0 )
+        {
+            const ssize_t n = ::read( fd, p, size );
+            if( n < 0 && errno == EINTR )
+                continue;
+            if( n <= 0 )
+                return false;
+            p += n;
+            size -= static_cast<std::size_t>( n );
+        }
+        return true;
+    }
+
+#ifdef MSG_NOSIGNAL
+    const int s_sendFlags = MSG_NOSIGNAL;
+#else
+    const int s_sendFlags = 0;
+#endif
+
+    /**
+     * keeps the writes to a socket from raising SIGPIPE where send() has no MSG_NOSIGNAL flag:
+     * with SO_NOSIGPIPE on the socket, else by ignoring SIGPIPE in the whole process
+     */
+    inline void noSigPipe( int fd )
+    {
+#if defined( MSG_NOSIGNAL )
+        (void)fd;
+#elif defined( SO_NOSIGPIPE )
+        const int on = 1;
+        ::setsockopt( fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof( on ) );
+#else
+        (void)fd;
+        std::signal( SIGPIPE, SIG_IGN );
+#endif
+    }
+
+    /**
+     * writes exactly size bytes, without raising SIGPIPE on a socket passed to noSigPipe()
+     * 
+     * @return false on error
+     */
+    inline bool writeAll( int fd, const void* data, std::size_t size )
+    {
+        const char* p = static_cast<const char*>( data );
+        while( size > 0 )
+        {
+            const ssize_t n = ::send( fd, p, size, s_sendFlags );
+            if( n < 0 && errno == EINTR )
+                continue;
+            if( n <= 0 )
+                return false;
+            p += n;
+            size -= static_cast<std::size_t>( n );
+        }
+        return true;
+    }
+}
\ No newline at end of file
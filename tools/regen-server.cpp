@@ -0,0 +1,735 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2018 Sébastien Débia
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+*/
+
+/*
+ * regen-server: serves the strings of a pattern library over a Unix domain socket
+ * 
+ * the library is compiled once at startup, in parallel and with its identical nodes shared
+ * (@see regen::compileLibrary). Each line of the pattern file is a name
+ * followed by a regex, empty lines and lines starting with # are ignored,
+ * the pattern id of a request is the index of the pattern in the file:
+ * 
+ *     plate [A-Z]{3}[0-9]{6}
+ *     word  [a-z]+
+ * 
+ * the requests of all the clients waiting at the same time are batched: their blocks of strings
+ * are grouped by pattern into tasks run by a pool of worker threads, which stream
+ * each block back as soon as it is generated (@see regen-protocol.hpp for the framing).
+ * 
+ * the workers never write to the sockets: each connection has a reader thread and a writer thread
+ * draining its queue of frames. A client which does not read its responses fills its queue,
+ * the connection is then dropped instead of blocking the workers.
+ * 
+ * --window is how long the dispatcher waits for more requests before batching them,
+ * --stats prints the statistics every given number of seconds, clients can also request them.
+ * --max-count is the number of strings above which a request is rejected,
+ * --max-queue the MB of frames a connection may have waiting before it is dropped.
+ * 
+ * usage: regen-server [--max N] [--min N] [--range SET] [--threads N] [--window US] [--stats S]
+ *                     [--max-count N] [--max-queue MB] patterns.txt socket
+ */
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cctype>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "regen/regen.hpp"
+#include "regen-protocol.hpp"
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    /** a task runs blocks until it has generated this many strings */
+    const std::size_t s_taskStrings = 4 * regen_protocol::s_blockSize;
+
+    /** the dispatcher stops waiting for more requests once this many are waiting */
+    const std::size_t s_maxBatch = 1024;
+
+    volatile std::sig_atomic_t s_stop = 0;
+
+    void onSignal( int )
+    {
+        s_stop = 1;
+    }
+
+    struct Entry
+    {
+        std::string name;
+        std::unique_ptr<const regen::Pattern> pattern;
+    };
+
+    bool isIdentifier( const std::string& name )
+    {
+        if( name.empty() || std::isdigit( static_cast<unsigned char>( name[0] ) ) )
+            return false;
+        for( unsigned char c : name )
+            if( !std::isalnum( c ) && c != '_' )
+                return false;
+        return true;
+    }
+
+    std::vector<Entry> load( const std::string& path, const regen::Generator& generator, std::size_t threads )
+    {
+        std::ifstream in( path );
+        if( !in )
+            throw std::runtime_error( "cannot open " + path );
+
+        std::vector<Entry> res;
+        std::vector<std::string> regexes;
+        std::string text;
+        for( std::size_t lineNumber = 1; std::getline( in, text ); ++lineNumber )
+        {
+            if( !text.empty() && text.back() == '\r' )
+                text.pop_back();
+            if( text.empty() || text[0] == '#' )
+                continue;
+
+            const std::size_t space = text.find_first_of( " \t" );
+            const std::string name = text.substr( 0, space );
+            const std::size_t start = space == std::string::npos ? space : text.find_first_not_of( " \t", space );
+            if( !isIdentifier( name ) || start == std::string::npos )
+                throw std::runtime_error( path + ":" + std::to_string( lineNumber ) + ": expected a name and a regex" );
+
+            res.push_back( Entry{ name, nullptr } );
+            regexes.push_back( text.substr( start ) );
+        }
+
+        regen::Library library;
+        try
+        {
+            regen::ThreadPool pool( threads );
+            library = regen::compileLibrary( regexes, pool, generator );
+        }
+        catch( std::exception& ex )
+        {
+            throw std::runtime_error( path + ": " + ex.what() );
+        }
+        for( std::size_t i = 0; i < res.size(); ++i )
+            res[i].pattern = std::move( library.patterns[i] );
+
+        const regen::Library::Report& report = library.report;
+        std::cerr << "compiled " << report.patterns << " patterns in " << std::fixed << std::setprecision( 1 )
+                  << report.seconds * 1000 << " ms on " << report.threads << " threads, "
+                  << report.sharedNodes << " of " << report.nodes << " nodes shared ("
+                  << report.bytesSaved / 1024 << " KiB saved), " << report.resolvedSets << " sets resolved\n";
+        return res;
+    }
+
+    /**
+     * latencies in microseconds, bucket i > 0 counts the ones in [2^(i-1), 2^i)
+     */
+    class Histogram
+    {
+    public:
+        Histogram()
+        {
+            for( auto& bucket : m_buckets )
+                bucket = 0;
+        }
+
+        void add( std::uint64_t us )
+        {
+            std::size_t i = 0;
+            while( i < 63 && ( us >> i ) != 0 )
+                ++i;
+            m_buckets[i].fetch_add( 1, std::memory_order_relaxed );
+
+            std::uint64_t max = m_max.load( std::memory_order_relaxed );
+            while( us > max && !m_max.compare_exchange_weak( max, us, std::memory_order_relaxed ) )
+                ;
+        }
+
+        /** @return upper bound of the latency under which a ratio of the requests are */
+        std::uint64_t percentile( double ratio ) const
+        {
+            std::array<std::uint64_t, 64> counts;
+            std::uint64_t total = 0;
+            for( std::size_t i = 0; i < counts.size(); ++i )
+                total += counts[i] = m_buckets[i].load( std::memory_order_relaxed );
+
+            std::uint64_t seen = 0;
+            for( std::size_t i = 0; i < counts.size(); ++i )
+            {
+                seen += counts[i];
+                if( seen > 0 && seen >= ratio * total )
+                    return std::min( i == 0 ? 0 : ( std::uint64_t( 1 ) << i ) - 1, max() );
+            }
+            return max();
+        }
+
+        std::uint64_t max() const { return m_max.load( std::memory_order_relaxed ); }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, 64> m_buckets;
+        std::atomic<std::uint64_t> m_max{ 0 };
+    };
+
+    struct Connection
+    {
+        explicit Connection( int fd ) : fd( fd ) {}
+        ~Connection() { ::close( fd ); }
+
+        const int fd;
+
+        /** guards the members below and the progress of the jobs of the connection */
+        std::mutex mutex;
+        std::condition_variable changed;
+
+        /** frames waiting for the writer and their bytes */
+        std::deque<std::string> frames;
+        std::size_t queued = 0;
+
+        /** requests not answered yet, the writer stops once they are all sent and the reader is done */
+        std::size_t jobs = 0;
+        bool reading = true;
+
+        /** false once the connection is dropped, the blocks of its requests are then skipped */
+        std::atomic<bool> alive{ true };
+
+        /** set when the reader and the writer are done, its thread can be joined */
+        std::atomic<bool> finished{ false };
+    };
+
+    /** a GENERATE request being served */
+    struct Job
+    {
+        std::shared_ptr<Connection> connection;
+        regen_protocol::Request request;
+        Clock::time_point received;
+
+        /** blocks of strings of the request */
+        std::uint32_t blocks;
+
+        /** blocks not sent yet, guarded by Connection::mutex */
+        std::uint32_t remaining;
+        bool done;
+    };
+
+    struct Block
+    {
+        std::shared_ptr<Job> job;
+        std::uint32_t index;
+    };
+
+    class Server
+    {
+    public:
+        Server( std::vector<Entry> library, std::size_t threads, std::chrono::microseconds window,
+                std::uint32_t maxCount, std::size_t maxQueued )
+        : m_library( std::move( library ) ),
+        m_window( window ),
+        m_maxCount( maxCount ),
+        m_maxQueued( maxQueued ),
+        m_start( Clock::now() ),
+        m_pool( threads ),
+        m_dispatcher( [this]{ dispatch(); } )
+        {
+        }
+
+        ~Server()
+        {
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_stopping = true;
+            }
+            m_ready.notify_all();
+            m_dispatcher.join();
+        }
+
+        /**
+         * accepts connections until SIGINT or SIGTERM
+         * 
+         * @param statsInterval seconds between the statistics printed on stderr, 0 for none
+         */
+        void serve( const std::string& path, double statsInterval )
+        {
+            sockaddr_un address;
+            std::memset( &address, 0, sizeof( address ) );
+            address.sun_family = AF_UNIX;
+            if( path.size() >= sizeof( address.sun_path ) )
+                throw std::runtime_error( "socket path too long: " + path );
+            std::strcpy( address.sun_path, path.c_str() );
+
+            struct stat st;
+            if( ::stat( path.c_str(), &st ) == 0 && S_ISSOCK( st.st_mode ) )
+                ::unlink( path.c_str() );
+
+            const int listening = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+            if( listening < 0
+                || ::bind( listening, reinterpret_cast<const sockaddr*>( &address ), sizeof( address ) ) != 0
+                || ::listen( listening, 128 ) != 0 )
+            {
+                const std::string error = std::strerror( errno );
+                if( listening >= 0 )
+                    ::close( listening );
+                throw std::runtime_error( "cannot listen on " + path + ": " + error );
+            }
+
+            std::vector<std::pair<std::thread, std::shared_ptr<Connection>>> sessions;
+            Clock::time_point printed = Clock::now();
+            while( !s_stop )
+            {
+                pollfd pfd{ listening, POLLIN, 0 };
+                if( ::poll( &pfd, 1, 200 ) > 0 )
+                {
+                    const int fd = ::accept( listening, nullptr, nullptr );
+                    if( fd >= 0 )
+                    {
+                        regen_protocol::noSigPipe( fd );
+                        auto connection = std::make_shared<Connection>( fd );
+                        sessions.emplace_back( std::thread( [this, connection]{ session( connection ); } ), connection );
+                    }
+                }
+
+                // the threads of the closed connections are joined as they go, not at shutdown
+                for( auto it = sessions.begin(); it != sessions.end(); )
+                {
+                    if( it->second->finished )
+                    {
+                        it->first.join();
+                        it = sessions.erase( it );
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+
+                if( statsInterval > 0 && std::chrono::duration<double>( Clock::now() - printed ).count() >= statsInterval )
+                {
+                    print( std::cerr );
+                    printed = Clock::now();
+                }
+            }
+
+            ::close( listening );
+            ::unlink( path.c_str() );
+
+            for( auto& session : sessions )
+            {
+                {
+                    std::lock_guard<std::mutex> lock( session.second->mutex );
+                    drop( *session.second );
+                }
+                session.first.join();
+            }
+        }
+
+        regen_protocol::Stats stats() const
+        {
+            regen_protocol::Stats res;
+            res.requests = m_requests.load( std::memory_order_relaxed );
+            res.failed = m_failed.load( std::memory_order_relaxed );
+            res.dropped = m_dropped.load( std::memory_order_relaxed );
+            res.strings = m_strings.load( std::memory_order_relaxed );
+            res.bytes = m_bytes.load( std::memory_order_relaxed );
+            res.batches = m_batches.load( std::memory_order_relaxed );
+            res.tasks = m_tasks.load( std::memory_order_relaxed );
+            res.latencyP50 = m_latencies.percentile( 0.5 );
+            res.latencyP90 = m_latencies.percentile( 0.9 );
+            res.latencyP99 = m_latencies.percentile( 0.99 );
+            res.latencyMax = m_latencies.max();
+            res.seconds = std::chrono::duration<double>( Clock::now() - m_start ).count();
+            res.requestsPerSecond = res.seconds > 0 ? res.requests / res.seconds : 0;
+            res.bytesPerSecond = res.seconds > 0 ? res.bytes / res.seconds : 0;
+            return res;
+        }
+
+        void print( std::ostream& out ) const
+        {
+            const regen_protocol::Stats s = stats();
+            out << std::fixed << std::setprecision( 1 )
+                << s.requests << " requests (" << s.failed << " failed), " << s.dropped << " connections dropped, " << s.strings << " strings, "
+                << s.bytes / 1e6 << " MB in " << s.batches << " batches / " << s.tasks << " tasks, "
+                << s.requestsPerSecond << " requests/s, " << s.bytesPerSecond / 1e6 << " MB/s, latency p50 "
+                << s.latencyP50 << " p90 " << s.latencyP90 << " p99 " << s.latencyP99 << " max " << s.latencyMax << " us\n";
+        }
+
+    private:
+        /** serves a connection until it is closed or dropped */
+        void session( const std::shared_ptr<Connection>& connection )
+        {
+            std::thread writer( [this, connection]{ write( *connection ); } );
+            read( connection );
+            {
+                std::lock_guard<std::mutex> lock( connection->mutex );
+                connection->reading = false;
+            }
+            connection->changed.notify_all();
+            writer.join();
+            connection->finished = true;
+        }
+
+        /** reads the requests of a connection until it is closed */
+        void read( const std::shared_ptr<Connection>& connection )
+        {
+            regen_protocol::Request request;
+            while( regen_protocol::readAll( connection->fd, &request, sizeof( request ) ) )
+            {
+                if( request.type == regen_protocol::STATS )
+                {
+                    const regen_protocol::Stats s = stats();
+                    const regen_protocol::Response response{ regen_protocol::STATS, request.id, regen_protocol::OK, regen_protocol::LAST, 0, 0, sizeof( s ) };
+                    std::lock_guard<std::mutex> lock( connection->mutex );
+                    queue( *connection, response, std::string( reinterpret_cast<const char*>( &s ), sizeof( s ) ) );
+                    continue;
+                }
+
+                const auto blocks = static_cast<std::uint32_t>( ( std::uint64_t( request.count ) + regen_protocol::s_blockSize - 1 ) / regen_protocol::s_blockSize );
+                auto job = std::make_shared<Job>( Job{ connection, request, Clock::now(), blocks, blocks, false } );
+                {
+                    std::lock_guard<std::mutex> lock( connection->mutex );
+                    ++connection->jobs;
+                }
+
+                if( request.type != regen_protocol::GENERATE )
+                    fail( *job, regen_protocol::INVALID_REQUEST, "unknown request type " + std::to_string( request.type ) );
+                else if( request.count > m_maxCount )
+                    fail( *job, regen_protocol::INVALID_REQUEST, "count " + std::to_string( request.count ) + " above the maximum " + std::to_string( m_maxCount ) );
+                else if( request.pattern >= m_library.size() )
+                    fail( *job, regen_protocol::INVALID_PATTERN, "no pattern " + std::to_string( request.pattern ) + ", the library has " + std::to_string( m_library.size() ) );
+                else if( request.count == 0 )
+                    send( *job, regen_protocol::Response{ regen_protocol::GENERATE, request.id, regen_protocol::OK, 0, 0, 0, 0 }, std::string() );
+                else
+                {
+                    {
+                        std::lock_guard<std::mutex> lock( m_mutex );
+                        m_waiting.push_back( std::move( job ) );
+                    }
+                    m_ready.notify_one();
+                }
+            }
+        }
+
+        /** batches the waiting requests into tasks of the pool */
+        void dispatch()
+        {
+            for( ;; )
+            {
+                std::vector<std::shared_ptr<Job>> jobs;
+                {
+                    std::unique_lock<std::mutex> lock( m_mutex );
+                    m_ready.wait( lock, [this]{ return m_stopping || !m_waiting.empty(); } );
+                    if( m_waiting.empty() )
+                        return;
+
+                    // requests arriving shortly after this one join the batch
+                    m_ready.wait_for( lock, m_window, [this]{ return m_stopping || m_waiting.size() >= s_maxBatch; } );
+                    jobs.swap( m_waiting );
+                }
+                m_batches.fetch_add( 1, std::memory_order_relaxed );
+
+                // grouped by pattern so that a task copies each pattern once
+                std::stable_sort( jobs.begin(), jobs.end(), []( const std::shared_ptr<Job>& a, const std::shared_ptr<Job>& b ) {
+                    return a->request.pattern < b->request.pattern;
+                } );
+
+                std::vector<Block> task;
+                std::size_t strings = 0;
+                for( const auto& job : jobs )
+                {
+                    for( std::uint32_t i = 0; i < job->blocks; ++i )
+                    {
+                        task.push_back( Block{ job, i } );
+                        strings += std::min<std::size_t>( regen_protocol::s_blockSize, job->request.count - std::size_t( i ) * regen_protocol::s_blockSize );
+                        if( strings >= s_taskStrings )
+                        {
+                            submit( std::move( task ) );
+                            task.clear();
+                            strings = 0;
+                        }
+                    }
+                }
+                if( !task.empty() )
+                    submit( std::move( task ) );
+            }
+        }
+
+        void submit( std::vector<Block> task )
+        {
+            m_tasks.fetch_add( 1, std::memory_order_relaxed );
+            auto shared = std::make_shared<std::vector<Block>>( std::move( task ) );
+            m_pool.submit( [this, shared]{ run( *shared ); } );
+        }
+
+        /** generates and sends blocks */
+        void run( const std::vector<Block>& task )
+        {
+            std::unique_ptr<regen::Pattern> pattern;
+            std::uint32_t patternId = 0;
+            std::vector<std::uint32_t> lengths;
+            std::string data;
+
+            for( const Block& block : task )
+            {
+                Job& job = *block.job;
+                if( !job.connection->alive )
+                    continue;
+
+                const std::uint32_t first = block.index * regen_protocol::s_blockSize;
+                const std::uint32_t count = std::min( regen_protocol::s_blockSize, job.request.count - first );
+                try
+                {
+                    if( !pattern || patternId != job.request.pattern )
+                    {
+                        pattern.reset( new regen::Pattern( *m_library[job.request.pattern].pattern ) );
+                        patternId = job.request.pattern;
+                    }
+                    pattern->seed( regen::substreamSeed( job.request.seed, block.index ) );
+
+                    data.clear();
+                    lengths.assign( count, 0 );
+                    for( std::uint32_t i = 0; i < count; ++i )
+                    {
+                        const std::size_t before = data.size();
+                        pattern->generate( data );
+                        lengths[i] = static_cast<std::uint32_t>( data.size() - before );
+                    }
+                }
+                catch( std::exception& ex )
+                {
+                    fail( job, regen_protocol::FAILED, ex.what() );
+                    continue;
+                }
+
+                std::string payload( reinterpret_cast<const char*>( lengths.data() ), lengths.size() * sizeof( std::uint32_t ) );
+                payload += data;
+                send( job, regen_protocol::Response{ regen_protocol::GENERATE, job.request.id, regen_protocol::OK, 0, first, count, 0 }, payload );
+            }
+        }
+
+        void fail( Job& job, regen_protocol::EStatus status, const std::string& message )
+        {
+            send( job, regen_protocol::Response{ job.request.type, job.request.id, status, 0, 0, 0, 0 }, message );
+        }
+
+        /**
+         * sends a frame of a request, the last one of the request has the LAST flag
+         * the frames of a request whose error was sent are dropped
+         */
+        void send( Job& job, regen_protocol::Response response, const std::string& payload )
+        {
+            Connection& connection = *job.connection;
+            std::lock_guard<std::mutex> lock( connection.mutex );
+            if( job.done )
+                return;
+
+            if( response.status != regen_protocol::OK || job.remaining <= 1 )
+            {
+                response.flags |= regen_protocol::LAST;
+                job.done = true;
+            }
+            else
+            {
+                --job.remaining;
+            }
+            response.size = payload.size();
+            m_strings.fetch_add( response.count, std::memory_order_relaxed );
+            if( response.status == regen_protocol::OK )
+                m_bytes.fetch_add( payload.size() - response.count * sizeof( std::uint32_t ), std::memory_order_relaxed );
+
+            queue( connection, response, payload );
+
+            if( job.done )
+            {
+                --connection.jobs;
+                connection.changed.notify_all();
+                m_requests.fetch_add( 1, std::memory_order_relaxed );
+                if( response.status != regen_protocol::OK )
+                    m_failed.fetch_add( 1, std::memory_order_relaxed );
+                m_latencies.add( std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - job.received ).count() );
+            }
+        }
+
+        /**
+         * queues a frame for the writer of a connection, under Connection::mutex
+         * a connection whose queue exceeds m_maxQueued bytes is dropped,
+         * a frame is always queued on an empty queue so that a large block does not drop a reading client
+         */
+        void queue( Connection& connection, const regen_protocol::Response& response, const std::string& payload )
+        {
+            if( !connection.alive )
+                return;
+
+            std::string frame( reinterpret_cast<const char*>( &response ), sizeof( response ) );
+            frame += payload;
+            if( !connection.frames.empty() && connection.queued + frame.size() > m_maxQueued )
+            {
+                m_dropped.fetch_add( 1, std::memory_order_relaxed );
+                drop( connection );
+                return;
+            }
+
+            connection.queued += frame.size();
+            connection.frames.push_back( std::move( frame ) );
+            connection.changed.notify_all();
+        }
+
+        /** closes a connection, under Connection::mutex: its reader and writer stop and its blocks are skipped */
+        void drop( Connection& connection )
+        {
+            connection.alive = false;
+            connection.frames.clear();
+            connection.queued = 0;
+            ::shutdown( connection.fd, SHUT_RDWR );
+            connection.changed.notify_all();
+        }
+
+        /** writes the frames of a connection until its requests are all answered and it is closed, or it is dropped */
+        void write( Connection& connection )
+        {
+            std::unique_lock<std::mutex> lock( connection.mutex );
+            for( ;; )
+            {
+                connection.changed.wait( lock, [&connection]{
+                    return !connection.alive || !connection.frames.empty() || ( !connection.reading && connection.jobs == 0 );
+                } );
+                if( !connection.alive || connection.frames.empty() )
+                    return;
+
+                const std::string frame = std::move( connection.frames.front() );
+                connection.frames.pop_front();
+                connection.queued -= frame.size();
+
+                lock.unlock();
+                const bool written = regen_protocol::writeAll( connection.fd, frame.data(), frame.size() );
+                lock.lock();
+                if( !written )
+                {
+                    drop( connection );
+                    return;
+                }
+            }
+        }
+
+        const std::vector<Entry> m_library;
+        const std::chrono::microseconds m_window;
+        const std::uint32_t m_maxCount;
+        const std::size_t m_maxQueued;
+        const Clock::time_point m_start;
+
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        std::vector<std::shared_ptr<Job>> m_waiting;
+        bool m_stopping = false;
+
+        std::atomic<std::uint64_t> m_requests{ 0 };
+        std::atomic<std::uint64_t> m_failed{ 0 };
+        std::atomic<std::uint64_t> m_dropped{ 0 };
+        std::atomic<std::uint64_t> m_strings{ 0 };
+        std::atomic<std::uint64_t> m_bytes{ 0 };
+        std::atomic<std::uint64_t> m_batches{ 0 };
+        std::atomic<std::uint64_t> m_tasks{ 0 };
+        Histogram m_latencies;
+
+        regen::ThreadPool m_pool;
+        std::thread m_dispatcher;
+    };
+
+    int usage()
+    {
+        std::cerr << "usage: regen-server [--max N] [--min N] [--range SET] [--threads N] [--window US] [--stats S]\n"
+                     "                    [--max-count N] [--max-queue MB] patterns.txt socket\n";
+        return 2;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    std::size_t repetition_max = 5;
+    std::size_t repetition_min = 0;
+    std::string restricted_range;
+    std::size_t threads = std::thread::hardware_concurrency();
+    long window = 100;
+    double statsInterval = 0;
+    std::uint32_t maxCount = 1 << 20;
+    std::size_t maxQueue = 64;
+    std::vector<std::string> files;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[i];
+        if( arg.compare( 0, 2, "--" ) != 0 )
+            files.push_back( arg );
+        else if( i + 1 == argc )
+            return usage();
+        else if( arg == "--max" )
+            repetition_max = std::stoul( argv[++i] );
+        else if( arg == "--min" )
+            repetition_min = std::stoul( argv[++i] );
+        else if( arg == "--range" )
+            restricted_range = argv[++i];
+        else if( arg == "--threads" )
+            threads = std::stoul( argv[++i] );
+        else if( arg == "--window" )
+            window = std::stol( argv[++i] );
+        else if( arg == "--stats" )
+            statsInterval = std::stod( argv[++i] );
+        else if( arg == "--max-count" )
+            maxCount = static_cast<std::uint32_t>( std::stoul( argv[++i] ) );
+        else if( arg == "--max-queue" )
+            maxQueue = std::stoul( argv[++i] );
+        else
+            return usage();
+    }
+    if( files.size() != 2 )
+        return usage();
+
+    try
+    {
+        const regen::Generator generator( repetition_max, repetition_min, restricted_range );
+        std::vector<Entry> library = load( files[0], generator, threads );
+
+        std::signal( SIGINT, onSignal );
+        std::signal( SIGTERM, onSignal );
+
+        Server server( std::move( library ), threads, std::chrono::microseconds( window ), maxCount, maxQueue << 20 );
+        std::cerr << "listening on " << files[1] << "\n";
+        server.serve( files[1], statsInterval );
+        server.print( std::cerr );
+    }
+    catch( std::exception& ex )
+    {
+        std::cerr << "error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file